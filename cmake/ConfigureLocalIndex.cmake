@@ -0,0 +1,28 @@
+################################################################################
+#
+# \file      ConfigureLocalIndex.cmake
+# \copyright 2020 Charmworks, Inc.
+#            All rights reserved. See the LICENSE file for details.
+# \brief     Configure the integer type of chare-local mesh indices
+#
+################################################################################
+
+# Configure the width of chare-local (mesh chunk) indices, i.e., element
+# connectivity with local node ids and indices of points and elements sent in
+# transfer messages. Global ids are always 64-bit.
+
+# Available options
+set(LOCAL_INDEX_VALUES "64" "32")
+# Initialize all to off
+set(LOCAL_INDEX_32BIT off)
+# Set default and select from list
+set(LOCAL_INDEX "64" CACHE STRING "Width of chare-local mesh indices in bits. Default: 64. Available options: ${LOCAL_INDEX_VALUES}.")
+SET_PROPERTY (CACHE LOCAL_INDEX PROPERTY STRINGS ${LOCAL_INDEX_VALUES})
+LIST (FIND LOCAL_INDEX_VALUES ${LOCAL_INDEX} LOCAL_INDEX_INDEX)
+# Evaluate selected option and put in a define for it
+IF (${LOCAL_INDEX_INDEX} EQUAL 1)
+  set(LOCAL_INDEX_32BIT on)
+ELSEIF (${LOCAL_INDEX_INDEX} EQUAL -1)
+  MESSAGE(FATAL_ERROR "Local index width '${LOCAL_INDEX}' not supported, valid entries are ${LOCAL_INDEX_VALUES}.")
+ENDIF()
+message(STATUS "Chare-local mesh index width: " ${LOCAL_INDEX} " bits")
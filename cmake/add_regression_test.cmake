@@ -40,6 +40,8 @@ endfunction()
 #                      [POSTPROCESS_PROG exec]
 #                      [POSTPROCESS_PROG_ARGS arg1 arg2 ...]
 #                      [POSTPROCESS_PROG_OUTPUT file]
+#                      [PERF_RESULT timings.csv]
+#                      [PERF_TOLERANCE percent]
 #
 # Mandatory arguments:
 # --------------------
@@ -123,12 +125,22 @@ endfunction()
 # POSTPROCESS_PROG_OUTPUT file - Filename to save the results of the
 # postprocessor program. Default: "".
 #
+# PERF_RESULT timings.csv - Transfer phase timings file produced by the test
+# (see exam2m::reportTimings), e.g., passed to exam2m by +m2m_timings. If given, the test is a performance test: it is
+# labeled "perf" and fails if any phase is slower than in the baseline stored
+# in PERF_BASELINE_DIR, see tests/CMakeLists.txt. If PERF_UPDATE_BASELINES is
+# set, the baseline is (re)written from the timings and the test passes. If
+# there is no baseline, the test fails. Default: "".
+#
+# PERF_TOLERANCE percent - Percentage a phase may be slower than its baseline
+# before the test fails. Default: PERF_TOLERANCE.
+#
 # ##############################################################################
 function(ADD_REGRESSION_TEST test_name executable)
 
   set(oneValueArgs NUMPES PPN TEXT_DIFF_PROG BIN_DIFF_PROG
                    FILECONV_PROG POSTPROCESS_PROG POSTPROCESS_PROG_OUTPUT
-                   CHECKPOINT)
+                   CHECKPOINT PERF_RESULT PERF_TOLERANCE)
   set(multiValueArgs INPUTFILES ARGS TEXT_BASELINE TEXT_RESULT BIN_BASELINE
                      BIN_RESULT LABELS POSTPROCESS_PROG_ARGS BIN_DIFF_PROG_ARGS
                      TEXT_DIFF_PROG_ARGS TEXT_DIFF_PROG_CONF BIN_DIFF_PROG_CONF
@@ -240,6 +252,9 @@ function(ADD_REGRESSION_TEST test_name executable)
   if (ARG_LABELS)
     list(APPEND TEST_LABELS ${ARG_LABELS})
   endif()
+  if (ARG_PERF_RESULT)
+    list(APPEND TEST_LABELS perf)
+  endif()
   # prepare test labels to pass as cmake script arguments
   set(ARG_LABELS ${TEST_LABELS})
   string(REPLACE ";" " " ARG_LABELS "${ARG_LABELS}")
@@ -382,6 +397,16 @@ function(ADD_REGRESSION_TEST test_name executable)
     string(REPLACE ";" " " POSTFIX_RUNNER_ARGS "${POSTFIX_RUNNER_ARGS}")
   endif()
 
+  # Configure performance check: one baseline per test, named after the test
+  if (ARG_PERF_RESULT)
+    string(REPLACE ":" "_" perf_baseline "${test_name}")
+    set(perf_baseline "${PERF_BASELINE_DIR}/${perf_baseline}.csv")
+    set(perf_tolerance ${PERF_TOLERANCE})
+    if (ARG_PERF_TOLERANCE)
+      set(perf_tolerance ${ARG_PERF_TOLERANCE})
+    endif()
+  endif()
+
   # Add the test. See test_runner.cmake for documentation of the arguments.
   add_test(NAME ${test_name}
            COMMAND ${CMAKE_COMMAND}
@@ -419,6 +444,11 @@ function(ADD_REGRESSION_TEST test_name executable)
            -DPOSTPROCESS_PROG_ARGS=${ARG_POSTPROCESS_PROG_ARGS}
            -DPOSTPROCESS_PROG_OUTPUT=${ARG_POSTPROCESS_PROG_OUTPUT}
            -DCHARM_SMP=${CHARM_SMP}
+           -DPERF_RESULT=${ARG_PERF_RESULT}
+           -DPERF_BASELINE=${perf_baseline}
+           -DPERF_TOLERANCE=${perf_tolerance}
+           -DPERF_NOISE_MS=${PERF_NOISE_MS}
+           -DPERF_UPDATE_BASELINES=${PERF_UPDATE_BASELINES}
            -P ${TEST_RUNNER}
            WORKING_DIRECTORY ${workdir})
 
@@ -436,6 +466,11 @@ function(ADD_REGRESSION_TEST test_name executable)
   if (ARG_BIN_BASELINE)
     list(APPEND pass_regexp "Binary diff found match")
   endif()
+  # add pass regular expression for performance check if needed
+  if (ARG_PERF_RESULT)
+    list(APPEND pass_regexp "Performance check passed"
+                            "Performance baseline written")
+  endif()
   # add pass regular expression for when postprocessor not available, if needed
   if (ENABLE_MESHCONV AND NOT GMSH_FOUND)
     list(APPEND pass_regexp "would be required for this test to be rigorous")
@@ -453,6 +488,10 @@ function(ADD_REGRESSION_TEST test_name executable)
                             "has not been matched to any"
                             "exodiff: ERROR")
   endif()
+  # add fail regular expression for performance check if needed
+  if (ARG_PERF_RESULT)
+    list(APPEND fail_regexp "Performance regression")
+  endif()
   # add fail regular expression if running with valgrind
   if (ENABLE_VALGRIND)
     list(APPEND fail_regexp "ERROR SUMMARY: [1-9][0-9]* errors")
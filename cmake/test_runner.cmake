@@ -71,6 +71,12 @@ message("  FILE_CONV_PROG (File conv tool program)                     : ${FILEC
 message("  FILE_CONV_INPUT (File conv tool input file(s))              : ${FILECONV_INPUT}")
 message("  FILECONV_RESULT (File conv tool output file(s))             : ${FILECONV_RESULT}")
 
+message("  PERF_RESULT (transfer phase timings produced by test)       : ${PERF_RESULT}")
+message("  PERF_BASELINE (transfer phase timings baseline)             : ${PERF_BASELINE}")
+message("  PERF_TOLERANCE (percent a phase may be slower than baseline): ${PERF_TOLERANCE}")
+message("  PERF_NOISE_MS (slowdown in ms always tolerated)             : ${PERF_NOISE_MS}")
+message("  PERF_UPDATE_BASELINES (overwrite baseline with timings)     : ${PERF_UPDATE_BASELINES}")
+
 # Remove previous test output (if any)
 if ( NOT CHECKPOINT AND
      (TEXT_RESULT OR BIN_RESULT OR FILECONV_RESULT OR FILECONV_INPUT) )
@@ -78,6 +84,11 @@ if ( NOT CHECKPOINT AND
   file(REMOVE ${TEXT_RESULT} ${BIN_RESULT} ${FILECONV_RESULT} ${FILECONV_INPUT})
 endif()
 
+# Remove previous timings (if any), since timings are appended to the file
+if (PERF_RESULT)
+  file(REMOVE ${PERF_RESULT})
+endif()
+
 # Set Charm++'s +ppn argument (if configured, used in SMP mode)
 if (PPN)
   set(PPN "+ppn;${PPN}")
@@ -399,3 +410,82 @@ else() # Test command ran successfully, attempt to do diffs
   endif()
 
 endif()
+
+# Do performance check if PERF_RESULT has been specified. The time of a phase
+# is the time of the slowest PE (the max column), taking the fastest of all
+# iterations to filter out warm-up and noise. The test fails if the time of any
+# phase exceeds its baseline by more than PERF_TOLERANCE percent and by more
+# than PERF_NOISE_MS milliseconds. Times are compared in integer microseconds,
+# as cmake can only do integer arithmetic.
+if (PERF_RESULT)
+
+  if (NOT EXISTS ${PERF_RESULT})
+    message(FATAL_ERROR "Performance regression check failed: test did not produce timings file '${PERF_RESULT}'")
+  endif()
+
+  # Collect fastest time (in microseconds) of each phase across iterations
+  set(phases)
+  file(STRINGS ${PERF_RESULT} lines)
+  list(REMOVE_AT lines 0)       # remove header
+  foreach(line IN LISTS lines)
+    string(REPLACE "," ";" fields "${line}")
+    list(GET fields 2 phase)
+    list(GET fields 4 time)
+    # Convert seconds to microseconds
+    string(REGEX MATCH "^([0-9]*)\\.?([0-9]*)$" time "${time}")
+    string(SUBSTRING "${CMAKE_MATCH_2}000000" 0 6 usec)
+    math(EXPR time "0${CMAKE_MATCH_1} * 1000000 + ${usec}")
+    if (NOT DEFINED time_${phase} OR time LESS time_${phase})
+      set(time_${phase} ${time})
+    endif()
+    list(FIND phases ${phase} i)
+    if (i EQUAL -1)
+      list(APPEND phases ${phase})
+    endif()
+  endforeach()
+
+  if (NOT PERF_UPDATE_BASELINES AND NOT EXISTS ${PERF_BASELINE})
+    message(FATAL_ERROR "Performance regression check failed: no baseline '${PERF_BASELINE}', record it with PERF_UPDATE_BASELINES=on and commit it")
+  endif()
+
+  if (PERF_UPDATE_BASELINES)
+
+    # Write new baseline
+    set(baseline "phase,usec\n")
+    foreach(phase IN LISTS phases)
+      string(APPEND baseline "${phase},${time_${phase}}\n")
+    endforeach()
+    file(WRITE ${PERF_BASELINE} "${baseline}")
+    message("\nPerformance baseline written: ${PERF_BASELINE}")
+
+  else()
+
+    # Compare timings to baseline
+    set(regressed)
+    file(STRINGS ${PERF_BASELINE} lines)
+    list(REMOVE_AT lines 0)     # remove header
+    foreach(line IN LISTS lines)
+      string(REPLACE "," ";" fields "${line}")
+      list(GET fields 0 phase)
+      list(GET fields 1 base)
+      if (NOT DEFINED time_${phase})
+        message(FATAL_ERROR "Performance regression check failed: phase '${phase}' in baseline '${PERF_BASELINE}' missing from timings")
+      endif()
+      math(EXPR limit "${base} * (100 + ${PERF_TOLERANCE}) / 100")
+      math(EXPR noise "${base} + ${PERF_NOISE_MS} * 1000")
+      message("  ${phase}: ${time_${phase}} usec, baseline: ${base} usec")
+      if (time_${phase} GREATER limit AND time_${phase} GREATER noise)
+        list(APPEND regressed "${phase} (${time_${phase}} > ${base} usec)")
+      endif()
+    endforeach()
+
+    if (regressed)
+      string(REPLACE ";" ", " regressed "${regressed}")
+      message(FATAL_ERROR "Performance regression beyond ${PERF_TOLERANCE}% against baseline '${PERF_BASELINE}': ${regressed}")
+    else()
+      message("\nPerformance check passed against baseline '${PERF_BASELINE}'")
+    endif()
+
+  endif()
+
+endif()
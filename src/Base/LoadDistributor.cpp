@@ -7,11 +7,13 @@
              All rights reserved. See the LICENSE file for details.
   \brief     Load distributors
   \details   Load distributors compute chunksize based on the degree of
-     virtualization.
+     virtualization, or based on a cost model of over-decomposition.
 */
 // *****************************************************************************
 
+#include <cmath>
 #include <limits>
+#include <algorithm>
 
 #include "Types.hpp"
 #include "LoadDistributor.hpp"
@@ -90,4 +92,64 @@ linearLoadDistributor( real virtualization,
   return nchare;
 }
 
+uint64_t
+autoLoadDistributor( uint64_t load,
+                     uint64_t totalload,
+                     int npe,
+                     tk::real overhead,
+                     uint64_t& chunksize,
+                     uint64_t& remainder )
+// *****************************************************************************
+//  Compute load distribution minimizing a cost model of over-decomposition
+//! \param[in] load Load to distribute, e.g., number of cells of a mesh
+//! \param[in] totalload Total load sharing the processing elements, e.g.,
+//!   number of cells of all meshes taking part in a mesh-to-mesh transfer
+//! \param[in] npe Number of processing elements to distribute the load to
+//! \param[in] overhead Cost of a work unit independent of its size, e.g.,
+//!   messages and bookkeeping of a chare, in units of the cost of unit load
+//! \param[inout] chunksize Chunk size, see linearLoadDistributor()
+//! \param[inout] remainder Remainder, see linearLoadDistributor()
+//! \return Number of work units
+//! \details The number of work units per processing element, k, is chosen to
+//!   minimize the modeled time of a processing element
+//!
+//!   T(k) = w (1 + 1/k) + k c,
+//!
+//!   where
+//!    - w = totalload/npe, the average load of a processing element,
+//!    - w/k = the size of a work unit, modeling the load imbalance, as the
+//!      most loaded processing element carries about one work unit more than
+//!      the average, and
+//!    - c = overhead, the cost of a work unit independent of its size.
+//!
+//!   The minimum is at k = sqrt(w/c). All loads sharing the processing
+//!   elements are decomposed into work units of the same size, w/k, so the
+//!   number of work units of a load scales with its share of the total load.
+//!   The number of work units is at least npe, as with zero virtualization in
+//!   linearLoadDistributor(), and at most load.
+// *****************************************************************************
+{
+  Assert( npe > 0, "Number of processing elements must be larger than zero" );
+  Assert( load > 0 && totalload >= load, "Load must be positive and part of "
+          "the total load" );
+  Assert( overhead > 0.0, "Work unit overhead must be positive" );
+
+  // Compute optimal number of work units per processing element
+  const auto w = static_cast< real >( totalload ) / npe;
+  const auto k = std::max( 1.0, std::sqrt( w / overhead ) );
+
+  // Compute number of work units given the optimal work unit size
+  auto nchare = static_cast< uint64_t >(
+                  std::llround( static_cast< real >( load ) / (w/k) ) );
+  nchare = std::min( load,
+             std::max( nchare, static_cast< uint64_t >( npe ) ) );
+
+  // Compute chunksize and remainder as in linearLoadDistributor()
+  chunksize = load / nchare;
+  remainder = load - nchare * chunksize;
+
+  // Return number of work units (number of Charm++ chares)
+  return nchare;
+}
+
 } // tk::
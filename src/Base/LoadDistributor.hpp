@@ -7,7 +7,7 @@
              All rights reserved. See the LICENSE file for details.
   \brief     Load distributors
   \details   Load distributors compute chunksize based on the degree of
-     virtualization.
+     virtualization, or based on a cost model of over-decomposition.
 */
 // *****************************************************************************
 #ifndef LoadDistributor_h
@@ -27,6 +27,15 @@ linearLoadDistributor( tk::real virtualization,
                        uint64_t& chunksize,
                        uint64_t& remainder );
 
+//! Compute load distribution minimizing a cost model of over-decomposition
+uint64_t
+autoLoadDistributor( uint64_t load,
+                     uint64_t totalload,
+                     int npe,
+                     tk::real overhead,
+                     uint64_t& chunksize,
+                     uint64_t& remainder );
+
 } // tk::
 
 #endif // LoadDistributor_h
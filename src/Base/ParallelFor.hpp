@@ -0,0 +1,100 @@
+// *****************************************************************************
+/*!
+  \file      src/Base/ParallelFor.hpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Shared-memory parallel loops over the PEs of a logical node
+  \details   Shared-memory parallel loops over the PEs of a logical node. In
+    Charm++'s SMP mode the loop is split into chunks executed by the worker
+    threads of the calling PE's logical node using CkLoop. In non-SMP mode, or
+    for loops too short to benefit, the loop body is called once for the whole
+    range on the calling PE.
+  \note CkLoop must have been initialized, via initParallelFor(), before
+    using these loops in SMP mode. The transfer library does this in
+    exam2m::LibMain, other main chares using these loops call it as well.
+*/
+// *****************************************************************************
+#ifndef ParallelFor_h
+#define ParallelFor_h
+
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+
+#include "NoWarning/charm.hpp"
+#if CMK_SMP
+  #include "NoWarning/ckloop.hpp"
+#endif
+
+namespace tk {
+
+namespace detail {
+
+//! CkLoop helper function calling a loop body on a chunk of the loop range
+//! \param[in] first First index of the chunk
+//! \param[in] last Last index of the chunk (inclusive, CkLoop convention)
+//! \param[in] param Pointer to the loop body
+template< class Body >
+void parallelForChunk( int first, int last, void*, int, void* param ) {
+  auto& body = *static_cast< Body* >( param );
+  body( static_cast< std::size_t >( first ),
+        static_cast< std::size_t >( last ) + 1 );
+}
+
+} // detail::
+
+//! Initialize CkLoop used by parallelFor() on the worker threads of nodes
+//! \details Must be called by a main chare. May be called by multiple main
+//!   chares, e.g., of an executable and of a library it links, as only the
+//!   first call initializes CkLoop.
+inline void initParallelFor() {
+  #if CMK_SMP
+  static bool initialized = false;
+  if (!initialized) {
+    CkLoop_Init( -1 );
+    initialized = true;
+  }
+  #endif
+}
+
+//! Number of threads that may execute a parallel loop issued on this PE
+inline std::size_t parallelWidth() {
+  #if CMK_SMP
+  return static_cast< std::size_t >( CkMyNodeSize() );
+  #else
+  return 1;
+  #endif
+}
+
+//! Execute a loop in parallel over the PEs of the calling PE's logical node
+//! \param[in] n Number of loop iterations, the loop range is [0,n)
+//! \param[in] body Loop body called as body(first,last) for the half-open
+//!   chunk [first,last) of the loop range
+//! \param[in] grain Minimum number of iterations per chunk
+//! \details The loop returns after all chunks have completed. Chunks may
+//!   execute concurrently, so the loop body must only write to locations
+//!   disjoint between chunks (or synchronize otherwise). Loops whose range
+//!   does not fit CkLoop's int indices are executed serially.
+template< class Body >
+void parallelFor( std::size_t n, Body body, std::size_t grain = 4096 ) {
+  if (n == 0) return;
+  #if CMK_SMP
+  auto nchunk = std::min( 4*parallelWidth(), n/std::max(grain,std::size_t(1)) );
+  if (nchunk > 1 &&
+      n-1 <= static_cast< std::size_t >( std::numeric_limits< int >::max() ))
+  {
+    CkLoop_Parallelize( detail::parallelForChunk< Body >, 1,
+                        static_cast< void* >( &body ),
+                        static_cast< int >( nchunk ),
+                        0, static_cast< int >( n-1 ) );
+    return;
+  }
+  #else
+  (void) grain;
+  #endif
+  body( std::size_t(0), n );
+}
+
+} // tk::
+
+#endif // ParallelFor_h
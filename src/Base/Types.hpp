@@ -10,11 +10,25 @@
 #ifndef Types_h
 #define Types_h
 
+#include <cstdint>
+#include <cstddef>
+
+#include "ExaM2MConfig.hpp"
+
 namespace tk {
 
 //! Real number type used throughout the whole code.
 using real = double;
 
+//! \brief Index type used for chare-local (mesh chunk) indices, e.g., element
+//!   connectivity with local node ids, while global ids are always std::size_t
+//! \details Configured by cmake -DLOCAL_INDEX=32|64.
+#ifdef LOCAL_INDEX_32BIT
+using lindex = uint32_t;
+#else
+using lindex = std::size_t;
+#endif
+
 } // tk::
 
 #endif // Types_h
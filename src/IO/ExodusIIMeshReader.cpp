@@ -11,6 +11,7 @@
 // *****************************************************************************
 
 #include <numeric>
+#include <algorithm>
 
 #include "ExodusIIMeshReader.hpp"
 #include "ContainerUtil.hpp"
@@ -42,12 +43,14 @@ ExodusIIMeshReader::ExodusIIMeshReader( const std::string& filename,
 //! \param[in] filename File to open as ExodusII file
 //! \param[in] cpuwordsize Set CPU word size, see ExodusII documentation
 //! \param[in] iowordsize Set I/O word size, see ExodusII documentation
+//! \details The file is opened with the 64-bit integer API, so all integer
+//!   data is passed as int64_t, whether the file stores 32- or 64-bit ints.
 // *****************************************************************************
 {
   float version;
 
-  m_inFile = ex_open( filename.c_str(), EX_READ, &cpuwordsize, &iowordsize,
-                      &version );
+  m_inFile = ex_open( filename.c_str(), EX_READ | EX_ALL_INT64_API,
+                      &cpuwordsize, &iowordsize, &version );
 
   ErrChk( m_inFile > 0, "Failed to open ExodusII file: " + filename );
 }
@@ -187,7 +190,7 @@ ExodusIIMeshReader::readHeader()
 // *****************************************************************************
 {
   char title[MAX_LINE_LENGTH+1];
-  int ndim, n, nnodeset, nelemset, nnode, neblk;
+  int64_t ndim, n, nnodeset, nelemset, nnode, neblk;
 
   ErrChk(
     ex_get_init( m_inFile, title, &ndim, &nnode, &n, &neblk, &nnodeset,
@@ -314,7 +317,7 @@ ExodusIIMeshReader::readElemBlockIDs()
   // Read ExodusII file header
   auto nnode = readHeader();
 
-  std::vector< int > bid( m_neblk );
+  std::vector< int64_t > bid( m_neblk );
 
   // Read element block ids
   ErrChk( ex_get_ids( m_inFile, EX_ELEM_BLOCK, bid.data()) == 0,
@@ -330,7 +333,7 @@ ExodusIIMeshReader::readElemBlockIDs()
   // Fill element block ID vector
   for (auto id : bid) {
     char eltype[MAX_STR_LENGTH+1];
-    int n, nnpe, nattr;
+    int64_t n, nnpe, nattr;
 
     // Read element block information
     ErrChk( ex_get_block( m_inFile, EX_ELEM_BLOCK, id, eltype, &n, &nnpe,
@@ -343,19 +346,14 @@ ExodusIIMeshReader::readElemBlockIDs()
 
     auto nel = static_cast< std::size_t >( n );
 
-    // Store info on ExodusII element blocks
-    if (nnpe == 4) {        // tetrahedra
+    // Store info on ExodusII element blocks of the supported cell types:
+    // tetrahedra, triangles, pyramids, prisms (wedges), and hexahedra
+    auto t = std::find( begin(ExoNnpe), end(ExoNnpe),
+                        static_cast< std::size_t >( nnpe ) );
+    if (t != end(ExoNnpe)) {
 
-      m_elemblocks.push_back( { ExoElemType::TET, nel } );
-      auto e = static_cast< std::size_t >( ExoElemType::TET );
-      m_blockid_by_type[ e ].push_back( id );
-      m_nel[ e ].push_back( nel );
-      Assert( m_blockid_by_type[e].size() == m_nel[e].size(), "Size mismatch" );
-
-    } else if (nnpe == 3) { // triangles
-
-      m_elemblocks.push_back( { ExoElemType::TRI, nel } );
-      auto e = static_cast< std::size_t >( ExoElemType::TRI );
+      auto e = static_cast< std::size_t >( t - begin(ExoNnpe) );
+      m_elemblocks.push_back( { static_cast< ExoElemType >( e ), nel } );
       m_blockid_by_type[ e ].push_back( id );
       m_nel[ e ].push_back( nel );
       Assert( m_blockid_by_type[e].size() == m_nel[e].size(), "Size mismatch" );
@@ -378,7 +376,7 @@ ExodusIIMeshReader::readAllElements( UnsMesh& mesh )
 
   for (auto id : m_blockid) {
     char eltype[MAX_STR_LENGTH+1];
-    int nel, nnpe, nattr;
+    int64_t nel, nnpe, nattr;
 
     // Read element block information
     ErrChk( ex_get_block( m_inFile, EX_ELEM_BLOCK, id, eltype, &nel, &nnpe,
@@ -390,7 +388,7 @@ ExodusIIMeshReader::readAllElements( UnsMesh& mesh )
     auto connectsize = static_cast< std::size_t >( nel*nnpe );
     if (nnpe == 4) {    // tetrahedra
 
-      std::vector< int > inpoel( connectsize );
+      std::vector< int64_t > inpoel( connectsize );
       ErrChk( ex_get_conn( m_inFile, EX_ELEM_BLOCK, id, inpoel.data(),
                            nullptr, nullptr ) == 0,
         "Failed to read " + std::string(eltype) + " element connectivity from "
@@ -400,7 +398,7 @@ ExodusIIMeshReader::readAllElements( UnsMesh& mesh )
 
     } else if (nnpe == 3) {    // triangles
 
-      std::vector< int > inpoel( connectsize );
+      std::vector< int64_t > inpoel( connectsize );
       ErrChk( ex_get_conn( m_inFile, EX_ELEM_BLOCK, id, inpoel.data(),
                            nullptr, nullptr ) == 0,
         "Failed to read " + std::string(eltype) + " element connectivity from "
@@ -497,13 +495,13 @@ ExodusIIMeshReader::readElements( const std::array< std::size_t, 2 >& ext,
           "Total number of elements to read incorrect, requested extents: " +
           std::to_string(ext[0]) + " ... " + std::to_string(ext[1]) );
 
-  std::vector< int > inpoel;
+  std::vector< int64_t > inpoel;
 
   // Read element connectivity from file
   std::size_t B = 0;
   for (auto b=lo_bid; b<=hi_bid; ++b, ++B) {
     const auto& r = rext[B];
-    std::vector< int > c( (r[1]-r[0]+1) * ExoNnpe[e] );
+    std::vector< int64_t > c( (r[1]-r[0]+1) * ExoNnpe[e] );
     ErrChk( ex_get_partial_conn( m_inFile,
                                  EX_ELEM_BLOCK,
                                  bid[b],
@@ -528,7 +526,59 @@ ExodusIIMeshReader::readElements( const std::array< std::size_t, 2 >& ext,
   // Put in element connectivity using zero-based node indexing
   for (auto& i : inpoel) --i;
   conn.reserve( conn.size() + inpoel.size() );
-  std::move( begin(inpoel), end(inpoel), std::back_inserter(conn) );
+  for (auto i : inpoel) conn.push_back( static_cast< std::size_t >( i ) );
+}
+
+void
+ExodusIIMeshReader::readCells( std::vector< std::size_t >& inpoel,
+                               std::vector< std::size_t >& cellptr )
+// *****************************************************************************
+//  Read connectivity of all volume cells of mixed type from ExodusII file
+//! \param[in,out] inpoel Container to store the connectivity of the cells,
+//!   the nodes of each cell in ExodusII order, using zero-based node ids
+//! \param[in,out] cellptr Container to store the offsets of the cells in
+//!   inpoel, one more than cells, the number of nodes of a cell giving its
+//!   type: 4 (tetrahedron), 5 (pyramid), 6 (prism), or 8 (hexahedron)
+//! \details Reads all element blocks of volume cells in the order as in the
+//!   file, so hex-dominant meshes can be passed to the transfer library as
+//!   they are, see exam2m::setSourceCells(), without tetrahedralizing them.
+// *****************************************************************************
+{
+  Assert( inpoel.empty() && cellptr.empty(),
+          "Containers to store cells must be empty" );
+
+  // Read element block ids
+  readElemBlockIDs();
+
+  cellptr.push_back( 0 );
+  for (auto id : m_blockid) {
+    char eltype[MAX_STR_LENGTH+1];
+    int64_t nel, nnpe, nattr;
+
+    // Read element block information
+    ErrChk( ex_get_block( m_inFile, EX_ELEM_BLOCK, id, eltype, &nel, &nnpe,
+                          &nattr, nullptr, nullptr ) == 0,
+      "Failed to read element block information from ExodusII file: " +
+      m_filename );
+
+    // Skip blocks of triangles and of unsupported cell types
+    if (nnpe != 4 && nnpe != 5 && nnpe != 6 && nnpe != 8) continue;
+
+    // Read element connectivity
+    std::vector< int64_t > c( static_cast< std::size_t >( nel*nnpe ) );
+    ErrChk( ex_get_conn( m_inFile, EX_ELEM_BLOCK, id, c.data(),
+                         nullptr, nullptr ) == 0,
+      "Failed to read " + std::string(eltype) + " element connectivity from "
+      "ExodusII file: " + m_filename );
+
+    // Put in element connectivity using zero-based node indexing
+    inpoel.reserve( inpoel.size() + c.size() );
+    for (auto i : c) inpoel.push_back( static_cast< std::size_t >( i-1 ) );
+    auto n = static_cast< std::size_t >( nnpe );
+    for (int64_t e=0; e<nel; ++e) cellptr.push_back( cellptr.back() + n );
+  }
+
+  Assert( cellptr.back() == inpoel.size(), "Size mismatch" );
 }
 
 void
@@ -563,7 +613,7 @@ ExodusIIMeshReader::readNodemap()
   auto nnode = readElemBlockIDs();
 
   // Create array to store node-number map
-  std::vector< int > node_map( nnode );
+  std::vector< int64_t > node_map( nnode );
 
   // Read in the node number map to map the above nodes to the global node-IDs
   ErrChk( ex_get_id_map( m_inFile, EX_NODE_MAP, node_map.data() ) == 0,
@@ -594,12 +644,12 @@ ExodusIIMeshReader::readSidesetNodes()
 
   if (m_neset > 0) {
     // Read all side set ids from file
-    std::vector< int > ids( m_neset );
+    std::vector< int64_t > ids( m_neset );
     ErrChk( ex_get_ids( m_inFile, EX_SIDE_SET, ids.data() ) == 0,
             "Failed to read side set ids from ExodusII file: " + m_filename );
     // Read in node list for all side sets
     for (auto i : ids) {
-      int nface, nnode;
+      int64_t nface, nnode;
       // Read number of faces and number of distribution factors in side set i
       ErrChk( ex_get_set_param( m_inFile, EX_SIDE_SET, i, &nface, &nnode ) == 0,
               "Failed to read side set " + std::to_string(i) + " parameters "
@@ -609,8 +659,8 @@ ExodusIIMeshReader::readSidesetNodes()
               "Failed to read side set " + std::to_string(i) + " node list "
               "length from ExodusII file: " + m_filename );
       Assert(nnode > 0, "Number of nodes = 0 in side set" + std::to_string(i));
-      std::vector< int > df( static_cast< std::size_t >( nface ) );
-      std::vector< int > nodes( static_cast< std::size_t >( nnode ) );
+      std::vector< int64_t > df( static_cast< std::size_t >( nface ) );
+      std::vector< int64_t > nodes( static_cast< std::size_t >( nnode ) );
       // Read in node list for side set i
       ErrChk( ex_get_side_set_node_list( m_inFile, i, df.data(), nodes.data() )
                 == 0, "Failed to read node list of side set " +
@@ -619,7 +669,7 @@ ExodusIIMeshReader::readSidesetNodes()
       // Make node list unique
       tk::unique( nodes );
       // Store 0-based node ID list as std::size_t vector instead of ints
-      auto& list = side[ i ];
+      auto& list = side[ static_cast< int >( i ) ];
       for (auto n : nodes) list.push_back( static_cast<std::size_t>(n-1) );
     }
   }
@@ -642,13 +692,13 @@ ExodusIIMeshReader::readSidesetFaces(
 
   if (m_neset > 0) {
     // Read side set ids from file
-    std::vector< int > ids( m_neset );
+    std::vector< int64_t > ids( m_neset );
     ErrChk( ex_get_ids( m_inFile, EX_SIDE_SET, ids.data() ) == 0,
             "Failed to read side set ids from ExodusII file: " + m_filename );
 
     // Read all side sets from file
     for (auto i : ids) {
-      int nface, nnode;
+      int64_t nface, nnode;
 
       // Read number of faces in side set
       ErrChk( ex_get_set_param( m_inFile, EX_SIDE_SET, i, &nface, &nnode ) == 0,
@@ -657,8 +707,8 @@ ExodusIIMeshReader::readSidesetFaces(
 
       Assert(nface > 0, "Number of faces = 0 in side set" + std::to_string(i));
 
-      std::vector< int > exoelem( static_cast< std::size_t >( nface ) );
-      std::vector< int > exoface( static_cast< std::size_t >( nface ) );
+      std::vector< int64_t > exoelem( static_cast< std::size_t >( nface ) );
+      std::vector< int64_t > exoface( static_cast< std::size_t >( nface ) );
 
       // Read in file-internal element ids and relative face ids for side set
       ErrChk( ex_get_set( m_inFile, EX_SIDE_SET, i, exoelem.data(),
@@ -666,13 +716,13 @@ ExodusIIMeshReader::readSidesetFaces(
               "Failed to read side set " + std::to_string(i) );
 
       // Store file-internal element ids of side set
-      auto& elem = bface[i];
+      auto& elem = bface[ static_cast< int >( i ) ];
       elem.resize( exoelem.size() );
       std::size_t j = 0;
       for (auto e : exoelem) elem[j++] = static_cast< std::size_t >( e-1 );
 
       // Store zero-based relative face ids of side set
-      auto& face = faces[i];
+      auto& face = faces[ static_cast< int >( i ) ];
       face.resize( exoface.size() );
       j = 0;
       for (auto n : exoface) face[j++] = static_cast< std::size_t >( n-1 );
@@ -701,27 +751,17 @@ ExodusIIMeshReader::blkRelElemId( std::size_t id ) const
 //! \note Must be preceded by a call to readElemBlockIDs()
 // *****************************************************************************
 {
-  auto TRI = tk::ExoElemType::TRI;
-  auto TET = tk::ExoElemType::TET;
-
   std::size_t e = 0;            // counts elements (independent of cell type)
-  std::size_t ntri = 0;         // counts triangle elements
-  std::size_t ntet = 0;         // counts tetrahedron elements
+  // counts elements of each cell type
+  std::array< std::size_t, ExoNnpe.size() > n{};
 
   for (const auto& b : m_elemblocks) {  // walk all element blocks in order
-    e += b.second;                      // increment file-internal element id
-    if (e > id) {                       // found element block for internal id
-      if (b.first == TRI) {             // if triangle block
-        return { TRI, id-ntet };        // return cell type and triangle id
-      } else if (b.first == TET) {      // if tetrahedron block
-        return { TET, id-ntri };        // return cell type and tetrahedron id
-      }
-    }
-    // increment triangle and tetrahedron elements independently
-    if (b.first == TRI)
-      ntri += b.second;
-    else if (b.first == TET)
-      ntet += b.second;
+    auto t = static_cast< std::size_t >( b.first );
+    if (e + b.second > id)              // found element block for internal id
+      return { b.first, id - e + n[t] };  // cell type and id relative to it
+    // increment file-internal element id and elements of the cell type
+    e += b.second;
+    n[t] += b.second;
   }
 
   Throw( " Exodus internal element id not found" );
@@ -835,5 +875,109 @@ ExodusIIMeshReader::nelem( tk::ExoElemType elemtype ) const
 // *****************************************************************************
 {
   auto e = static_cast< std::size_t >( elemtype );
-  return std::accumulate( m_nel[e].cbegin(), m_nel[e].cend(), 0u );
+  return std::accumulate( m_nel[e].cbegin(), m_nel[e].cend(),
+                          std::size_t{0} );
+}
+
+std::vector< tk::real >
+ExodusIIMeshReader::readTimeValues() const
+// *****************************************************************************
+//  Read the times of all time steps from ExodusII file
+//! \return Time values of all time steps in the file, empty if none
+// *****************************************************************************
+{
+  auto nstep = ex_inquire_int( m_inFile, EX_INQ_TIME );
+  ErrChk( nstep >= 0, "Failed to read number of time steps from ExodusII "
+                      "file: " + m_filename );
+
+  std::vector< tk::real > time( static_cast< std::size_t >( nstep ) );
+  if (!time.empty())
+    ErrChk( ex_get_all_times( m_inFile, time.data() ) == 0,
+            "Failed to read time values from ExodusII file: " + m_filename );
+
+  return time;
+}
+
+std::vector< std::string >
+ExodusIIMeshReader::readNodeVarNames() const
+// *****************************************************************************
+//  Read the names of nodal variables from ExodusII file
+//! \return Names of nodal variables in the order of their (1-based) ids
+// *****************************************************************************
+{
+  int nvar = 0;
+  ErrChk( ex_get_variable_param( m_inFile, EX_NODE_BLOCK, &nvar ) == 0,
+          "Failed to read number of nodal variables from ExodusII file: " +
+          m_filename );
+
+  auto n = static_cast< std::size_t >( nvar );
+  std::vector< std::vector< char > > buf( n,
+    std::vector< char >( MAX_STR_LENGTH+1, '\0' ) );
+  std::vector< char* > names( n );
+  for (std::size_t i=0; i<n; ++i) names[i] = buf[i].data();
+
+  if (nvar > 0)
+    ErrChk( ex_get_variable_names( m_inFile, EX_NODE_BLOCK, nvar,
+                                   names.data() ) == 0,
+            "Failed to read nodal variable names from ExodusII file: " +
+            m_filename );
+
+  std::vector< std::string > nv;
+  for (const auto& b : buf) nv.emplace_back( b.data() );
+  return nv;
+}
+
+std::vector< tk::real >
+ExodusIIMeshReader::readNodeScalar( uint64_t step,
+                                    int varid,
+                                    const std::vector< std::size_t >& gid )
+const
+// *****************************************************************************
+//  Read a nodal variable of a time step at a number of mesh nodes
+//! \param[in] step Time step (0-based) to read
+//! \param[in] varid Nodal variable id (1-based) to read
+//! \param[in] gid Global (file) node ids at which to read the variable
+//! \return Variable values at the nodes in the order of gid
+//! \details The nodes requested are sorted by file id and read in runs of
+//!   contiguous file ids, a call per run, so a mesh chunk reads only its own
+//!   nodes, whether or not they are close in the file. Runs separated by
+//!   fewer than maxgap nodes are read in a single call, which reads a few
+//!   values too many, but saves calls for chunks whose nodes interleave with
+//!   those of other chunks in the file.
+// *****************************************************************************
+{
+  const std::size_t maxgap = 64;
+
+  std::vector< tk::real > var( gid.size() );
+  if (gid.empty()) return var;
+
+  std::vector< std::size_t > order( gid.size() );
+  std::iota( begin(order), end(order), 0 );
+  std::sort( begin(order), end(order),
+             [&]( std::size_t a, std::size_t b ){ return gid[a] < gid[b]; } );
+
+  std::vector< tk::real > run;
+  for (std::size_t i=0; i<order.size(); ) {
+    auto j = i + 1;
+    while (j < order.size() && gid[order[j]] - gid[order[j-1]] < maxgap) ++j;
+    auto first = gid[ order[i] ];
+    run.resize( gid[ order[j-1] ] - first + 1 );
+
+    ErrChk( ex_get_partial_var( m_inFile,
+                                static_cast< int >( step+1 ),
+                                EX_NODE_BLOCK,
+                                varid,
+                                1,
+                                static_cast< int64_t >( first+1 ),
+                                static_cast< int64_t >( run.size() ),
+                                run.data() ) == 0,
+            "Failed to read nodal variable " + std::to_string(varid) +
+            " of time step " + std::to_string(step) + " from ExodusII file: " +
+            m_filename );
+
+    for (auto k=i; k<j; ++k) var[ order[k] ] = run[ gid[order[k]] - first ];
+    i = j;
+  }
+
+  return var;
 }
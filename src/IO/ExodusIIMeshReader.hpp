@@ -29,12 +29,12 @@ namespace tk {
 
 //! Supported ExodusII mesh cell types
 //! \see ExodusIIMeshReader::readElemBlockIDs()
-enum class ExoElemType : int { TET = 0, TRI = 1 };
+enum class ExoElemType : int { TET = 0, TRI = 1, PYR = 2, PRISM = 3, HEX = 4 };
 
 //! ExodusII mesh cell number of nodes
 //! \details List of number of nodes per element for different element types
 //!   supported in the order of tk::ExoElemType
-const std::array< std::size_t, 2 > ExoNnpe {{ 4, 3 }};
+const std::array< std::size_t, 5 > ExoNnpe {{ 4, 3, 5, 6, 8 }};
 
 //! ExodusII face-node numbering for tetrahedron side sets
 //! \see ExodusII manual figure on "Sideset side Numbering"
@@ -43,7 +43,10 @@ const std::array< std::array< std::size_t, 3 >, 4 >
 
 //! ExodusII mesh-based data reader
 //! \details Mesh reader class facilitating reading from mesh-based field data
-//!   a file in ExodusII format.
+//!   a file in ExodusII format. Files are opened with the 64-bit integer API,
+//!   so all counts, ids, and connectivities are read as 64-bit integers,
+//!   independent of how they are stored in the file, which allows reading
+//!   meshes with more than 2^31 nodes or elements.
 //! \see https://github.com/trilinos/Trilinos/tree/master/packages/seacas
 class ExodusIIMeshReader {
 
@@ -84,6 +87,10 @@ class ExodusIIMeshReader {
     readSidesetFaces( std::map< int, std::vector< std::size_t > >& bface,
                       std::map< int, std::vector< std::size_t > >& faces );
 
+    //! Read connectivity of all volume cells of mixed type from file
+    void readCells( std::vector< std::size_t >& inpoel,
+                    std::vector< std::size_t >& cellptr );
+
     //! Read face connectivity of a number boundary faces from file
     void readFaces( std::vector< std::size_t >& conn ) const;
 
@@ -125,6 +132,18 @@ class ExodusIIMeshReader {
     //!  Return number of elements in a mesh block in the ExodusII file
     std::size_t nelem( tk::ExoElemType elemtype ) const;
 
+    //! Read the times of all time steps from ExodusII file
+    std::vector< tk::real > readTimeValues() const;
+
+    //! Read the names of nodal variables from ExodusII file
+    std::vector< std::string > readNodeVarNames() const;
+
+    //! Read a nodal variable of a time step at a number of mesh nodes
+    std::vector< tk::real >
+    readNodeScalar( uint64_t step,
+                    int varid,
+                    const std::vector< std::size_t >& gid ) const;
+
     //! Copy assignment
     // cppcheck-suppress operatorEqVarError
     // cppcheck-suppress operatorEqMissingReturnStatement
@@ -133,8 +152,8 @@ class ExodusIIMeshReader {
       m_cpuwordsize = x.m_cpuwordsize;
       m_iowordsize = x.m_iowordsize;
       float version;
-      m_inFile = ex_open( m_filename.c_str(), EX_READ, &m_cpuwordsize,
-                          &m_iowordsize, &version );
+      m_inFile = ex_open( m_filename.c_str(), EX_READ | EX_ALL_INT64_API,
+                          &m_cpuwordsize, &m_iowordsize, &version );
       ErrChk( m_inFile > 0, "Failed to open ExodusII file: " + m_filename );
       m_nnode = x.m_nnode;
       m_neblk = x.m_neblk;
@@ -161,8 +180,8 @@ class ExodusIIMeshReader {
       m_cpuwordsize = x.m_cpuwordsize;
       m_iowordsize = x.m_iowordsize;
       float version;
-      m_inFile = ex_open( m_filename.c_str(), EX_READ, &m_cpuwordsize,
-                          &m_iowordsize, &version );
+      m_inFile = ex_open( m_filename.c_str(), EX_READ | EX_ALL_INT64_API,
+                          &m_cpuwordsize, &m_iowordsize, &version );
       ErrChk( m_inFile > 0, "Failed to open ExodusII file: " + m_filename );
       m_nnode = x.m_nnode;
       m_neblk = x.m_neblk;
@@ -176,8 +195,8 @@ class ExodusIIMeshReader {
       m_tri = x.m_tri;
       x.m_cpuwordsize = sizeof(double);
       x.m_iowordsize = sizeof(double);
-      x.m_inFile = ex_open( m_filename.c_str(), EX_READ, &x.m_cpuwordsize,
-                            &x.m_iowordsize, &version );
+      x.m_inFile = ex_open( m_filename.c_str(), EX_READ | EX_ALL_INT64_API,
+                            &x.m_cpuwordsize, &x.m_iowordsize, &version );
       ErrChk( x.m_inFile > 0, "Failed to open ExodusII file: " + m_filename );
       x.m_nnode = 0;
       x.m_neblk = 0;
@@ -221,9 +240,9 @@ class ExodusIIMeshReader {
     std::size_t m_from;                 //!< Lower bound of tet ids on this PE
     std::size_t m_till;                 //!< Upper bound of tet ids on this PE
     //! Element block IDs in the order as in the file
-    std::vector< int > m_blockid;
+    std::vector< int64_t > m_blockid;
     //! Element block IDs for each elem type
-    std::vector< std::vector< int > > m_blockid_by_type;
+    std::vector< std::vector< int64_t > > m_blockid_by_type;
     //! Number of elements in blocks for each elem type
     std::vector< std::vector< std::size_t > > m_nel;
     //! Cell type and number of elements in blocks in the order as in the file
@@ -33,6 +33,9 @@ ExodusIIMeshWriter::ExodusIIMeshWriter( const std::string& filename,
 //!   appending
 //! \param[in] cpuwordsize Set CPU word size, see ExodusII documentation
 //! \param[in] iowordsize Set I/O word size, see ExodusII documentation
+//! \details New files store all integer data, i.e., ids, maps, and
+//!   connectivities, as 64-bit integers, and all files are accessed through
+//!   the 64-bit integer API, so integer data is passed as int64_t.
 // *****************************************************************************
 {
   // Increase verbosity from ExodusII library in debug mode
@@ -43,7 +46,8 @@ ExodusIIMeshWriter::ExodusIIMeshWriter( const std::string& filename,
   if (mode == ExoWriter::CREATE) {
 
     m_outFile = ex_create( filename.c_str(),
-                           EX_CLOBBER | EX_LARGE_MODEL,
+                           EX_CLOBBER | EX_LARGE_MODEL | EX_ALL_INT64_DB |
+                             EX_ALL_INT64_API,
                            &cpuwordsize,
                            &iowordsize );
 
@@ -51,7 +55,7 @@ ExodusIIMeshWriter::ExodusIIMeshWriter( const std::string& filename,
 
     float version;
     m_outFile = ex_open( filename.c_str(),
-                         EX_WRITE, 
+                         EX_WRITE | EX_ALL_INT64_API,
                          &cpuwordsize,
                          &iowordsize,
                          &version );
@@ -167,6 +171,33 @@ ExodusIIMeshWriter::writeHeader( const UnsMesh& mesh ) const
     "Failed to write header to file: " + m_filename );
 }
 
+void
+ExodusIIMeshWriter::writeTimeStep(
+  uint64_t it,
+  tk::real time,
+  const std::vector< std::vector< tk::real > >& elemvars,
+  const std::vector< std::vector< tk::real > >& nodevars ) const
+// *****************************************************************************
+//  Write time stamp and all element and node fields of a time step
+//! \param[in] it Iteration number
+//! \param[in] time Time
+//! \param[in] elemvars Element fields, ids are assigned in order starting
+//!   from 1, empty fields are skipped
+//! \param[in] nodevars Node fields, ids are assigned in order starting from 1,
+//!   empty fields are skipped
+//! \details Writes the whole time step through the same open file, so that
+//!   callers keeping the file open across time steps only pay for the data.
+// *****************************************************************************
+{
+  writeTimeStamp( it, time );
+
+  int varid = 0;
+  for (const auto& v : elemvars) writeElemScalar( it, ++varid, v );
+
+  varid = 0;
+  for (const auto& v : nodevars) writeNodeScalar( it, ++varid, v );
+}
+
 void
 ExodusIIMeshWriter::writeHeader( const char* title,
                                  int64_t ndim,
@@ -283,9 +314,9 @@ const
     m_filename );
 
   // Write element connectivity with 1-based node ids
-  std::vector< int > inp( inpoel.size() );
+  std::vector< int64_t > inp( inpoel.size() );
   std::size_t i = 0;
-  for (auto p : inpoel) inp[ i++ ] = static_cast< int >( p+1 );
+  for (auto p : inpoel) inp[ i++ ] = static_cast< int64_t >( p+1 );
   ErrChk( ex_put_conn( m_outFile, EX_ELEM_BLOCK, elclass, inp.data(),
                        nullptr, nullptr ) == 0,
           "Failed to write " + eltype + " element connectivity to ExodusII "
@@ -306,15 +337,15 @@ ExodusIIMeshWriter::writeSidesets( const UnsMesh& mesh ) const
                               static_cast<int64_t>(s.second.size()), 0 ) == 0,
       "Failed to write side set parameters to ExodusII file: " + m_filename );
 
-    // ExodusII wants 32-bit integers as IDs of element ids
-    std::vector< int > bface( s.second.size() );
+    // 1-based element ids adjacent to side set
+    std::vector< int64_t > bface( s.second.size() );
     std::size_t i = 0;
-    for (auto f : s.second) bface[ i++ ] = static_cast<int>(f)+1;
-    // ExodusII wants 32-bit integers as element-relative face IDs
+    for (auto f : s.second) bface[ i++ ] = static_cast<int64_t>(f)+1;
+    // 1-based element-relative face ids
     const auto& fi = tk::cref_find( mesh.faceid(), s.first );
-    std::vector< int > faceid( fi.size() );
+    std::vector< int64_t > faceid( fi.size() );
     i = 0;
-    for (auto f : fi) faceid[ i++ ] = static_cast<int>(f)+1;
+    for (auto f : fi) faceid[ i++ ] = static_cast<int64_t>(f)+1;
 
     // Write side set data: ExodusII-file internal element ids adjacent to side
     // set and face id relative to element indicating which face is aligned with
@@ -339,10 +370,10 @@ ExodusIIMeshWriter::writeNodesets( const UnsMesh& mesh ) const
                               static_cast<int64_t>(s.second.size()), 0 ) == 0,
       "Failed to write side set parameters to ExodusII file: " + m_filename );
 
-    // ExodusII wants 32-bit integers as IDs of node ids
-    std::vector< int > bnode( s.second.size() );
+    // 1-based node ids of side set
+    std::vector< int64_t > bnode( s.second.size() );
     std::size_t i = 0;
-    for (auto n : s.second) bnode[ i++ ] = static_cast<int>(n)+1;
+    for (auto n : s.second) bnode[ i++ ] = static_cast<int64_t>(n)+1;
 
     // Write side set data
     ErrChk( ex_put_set( m_outFile, EX_NODE_SET, s.first, bnode.data(),
@@ -351,6 +382,25 @@ ExodusIIMeshWriter::writeNodesets( const UnsMesh& mesh ) const
   }
 }
 
+void
+ExodusIIMeshWriter::writeNodeIdMap( const std::vector< std::size_t >& gid )
+const
+// *****************************************************************************
+//  Write node number map to ExodusII file
+//! \param[in] gid Global (zero-based) node ids of the nodes in the file
+//! \details The node number map associates the nodes of a file written by a
+//!   part of the job with the node ids of the whole mesh, so that post
+//!   processing tools can glue the nodes shared by multiple files.
+// *****************************************************************************
+{
+  std::vector< int64_t > map( gid.size() );
+  for (std::size_t i=0; i<gid.size(); ++i)
+    map[i] = static_cast< int64_t >( gid[i] + 1 );
+
+  ErrChk( ex_put_id_map( m_outFile, EX_NODE_MAP, map.data() ) == 0,
+          "Failed to write node number map to ExodusII file: " + m_filename );
+}
+
 void
 ExodusIIMeshWriter::writeTimeStamp( uint64_t it, tk::real time ) const
 // *****************************************************************************
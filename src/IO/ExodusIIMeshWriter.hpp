@@ -29,7 +29,9 @@ enum class ExoWriter { CREATE, OPEN };
 
 //! ExodusII mesh-based data writer
 //! \details Mesh writer class facilitating writing a mesh and associated
-//!   mesh-based field data to a file in ExodusII format.
+//!   mesh-based field data to a file in ExodusII format. Files are written
+//!   with the 64-bit integer API and store 64-bit integers, so meshes with
+//!   more than 2^31 nodes or elements can be written.
 //! \see http://sourceforge.net/projects/exodusii
 class ExodusIIMeshWriter {
 
@@ -91,6 +93,13 @@ class ExodusIIMeshWriter {
                           int varid,
                           const std::vector< tk::real >& var ) const;
 
+    //! Write time stamp and all element and node fields of a time step
+    void writeTimeStep( uint64_t it,
+                        tk::real time,
+                        const std::vector< std::vector< tk::real > >& elemvars,
+                        const std::vector< std::vector< tk::real > >& nodevars )
+      const;
+
     //! Write header without mesh, function overloading
     void writeHeader( const char* title, int64_t ndim, int64_t nnodes,
                       int64_t nelem, int64_t nblk, int64_t node_set,
@@ -101,6 +110,9 @@ class ExodusIIMeshWriter {
                      const std::vector< tk::real >& y,
                      const std::vector< tk::real >& z ) const;
 
+    //! Write node number map to ExodusII file
+    void writeNodeIdMap( const std::vector< std::size_t >& gid ) const;
+
     //! Write element block to ExodusII file
     void writeElemBlock( int& elclass,
                          int64_t nnpe,
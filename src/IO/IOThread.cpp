@@ -0,0 +1,131 @@
+// *****************************************************************************
+/*!
+  \file      src/IO/IOThread.cpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Background thread for file output
+  \details   Definition of a process-wide background thread that executes
+     file output jobs in the order they are posted, so the PE posting them can
+     return to the Charm++ scheduler instead of blocking in file I/O.
+*/
+// *****************************************************************************
+
+#include "IOThread.hpp"
+
+using tk::IOThread;
+
+IOThread&
+IOThread::instance()
+// *****************************************************************************
+//  Access the thread of this process, starting it on first use
+//! \return Reference to the background thread of this process
+// *****************************************************************************
+{
+  static IOThread t;
+  return t;
+}
+
+IOThread::IOThread() : m_posted( 0 ), m_done( 0 ), m_stop( false )
+// *****************************************************************************
+//  Constructor: start the thread
+// *****************************************************************************
+{
+  m_thread = std::thread( [this](){ run(); } );
+}
+
+IOThread::~IOThread() noexcept
+// *****************************************************************************
+//  Destructor: finish all jobs posted and join the thread
+// *****************************************************************************
+{
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable()) m_thread.join();
+}
+
+uint64_t
+IOThread::post( std::function< void() >&& job )
+// *****************************************************************************
+//  Post a job to be executed in the background
+//! \param[in] job Job to execute, owning all data it needs
+//! \return Ticket of the job that can be waited on
+// *****************************************************************************
+{
+  uint64_t ticket;
+  {
+    std::lock_guard< std::mutex > lock( m_mutex );
+    rethrow();
+    m_jobs.push_back( std::move(job) );
+    ticket = ++m_posted;
+  }
+  m_cv.notify_all();
+  return ticket;
+}
+
+void
+IOThread::wait( uint64_t ticket )
+// *****************************************************************************
+//  Wait for a job and all jobs posted before it to finish
+//! \param[in] ticket Ticket of the job to wait for, 0 returns immediately
+// *****************************************************************************
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+  m_cv.wait( lock, [&](){ return m_done >= ticket || m_error; } );
+  rethrow();
+}
+
+void
+IOThread::drain()
+// *****************************************************************************
+//  Wait for all jobs posted to finish
+//! \details Rethrows the first exception thrown by a job, if any.
+// *****************************************************************************
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+  m_cv.wait( lock, [&](){ return m_done == m_posted || m_error; } );
+  rethrow();
+}
+
+void
+IOThread::run()
+// *****************************************************************************
+//  Execute jobs until stopped
+//! \details Jobs posted before stopping are still executed. Once a job threw,
+//!   later jobs are discarded, since they would likely write to the same
+//!   files, and the exception is rethrown on the thread posting or waiting.
+// *****************************************************************************
+{
+  std::unique_lock< std::mutex > lock( m_mutex );
+  for (;;) {
+    m_cv.wait( lock, [&](){ return m_stop || !m_jobs.empty(); } );
+    if (m_jobs.empty()) return;
+    auto job = std::move( m_jobs.front() );
+    m_jobs.pop_front();
+    if (!m_error) {
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        job();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error && !m_error) m_error = error;
+    }
+    ++m_done;
+    m_cv.notify_all();
+  }
+}
+
+void
+IOThread::rethrow()
+// *****************************************************************************
+//  Rethrow the first exception thrown by a job, if any
+//! \note Must be called with m_mutex locked.
+// *****************************************************************************
+{
+  if (m_error) std::rethrow_exception( m_error );
+}
@@ -0,0 +1,71 @@
+// *****************************************************************************
+/*!
+  \file      src/IO/IOThread.hpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Background thread for file output
+  \details   Declaration of a process-wide background thread that executes
+     file output jobs in the order they are posted, so the PE posting them can
+     return to the Charm++ scheduler instead of blocking in file I/O.
+*/
+// *****************************************************************************
+#ifndef IOThread_h
+#define IOThread_h
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace tk {
+
+//! Process-wide background thread executing file output jobs in order
+//! \details A single thread per process executes all jobs, so libraries that
+//!   are not thread-safe, e.g., NetCDF, HDF5, and ExodusII, are still called
+//!   from a single thread at a time, as long as the thread posting the jobs
+//!   does not call them at the same time. Jobs must not call into the Charm++
+//!   runtime system.
+class IOThread {
+
+  public:
+    //! Access the thread of this process, starting it on first use
+    static IOThread& instance();
+
+    //! Destructor: finish all jobs posted and join the thread
+    ~IOThread() noexcept;
+
+    //! Post a job to be executed in the background
+    uint64_t post( std::function< void() >&& job );
+
+    //! Wait for a job and all jobs posted before it to finish
+    void wait( uint64_t ticket );
+
+    //! Wait for all jobs posted to finish
+    void drain();
+
+  private:
+    std::mutex m_mutex;                 //!< Protects all data below
+    std::condition_variable m_cv;       //!< Signals jobs posted and finished
+    std::deque< std::function< void() > > m_jobs;     //!< Jobs not yet started
+    uint64_t m_posted;                  //!< Number of jobs posted
+    uint64_t m_done;                    //!< Number of jobs finished
+    bool m_stop;                        //!< True if the thread is to finish
+    std::exception_ptr m_error;         //!< First exception thrown by a job
+    std::thread m_thread;               //!< Background thread
+
+    //! Constructor: start the thread
+    IOThread();
+
+    //! Execute jobs until stopped
+    void run();
+
+    //! Rethrow the first exception thrown by a job, if any
+    void rethrow();
+};
+
+} // tk::
+
+#endif // IOThread_h
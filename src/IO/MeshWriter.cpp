@@ -11,15 +11,34 @@
 */
 // *****************************************************************************
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "MeshWriter.hpp"
 #include "Reorder.hpp"
 #include "ExodusIIMeshWriter.hpp"
+#include "IOThread.hpp"
+#include "ProcessException.hpp"
 
 using tk::MeshWriter;
 
-MeshWriter::MeshWriter() : m_nchare( 0 )
+MeshWriter::MeshWriter( bool aggregate, bool async ) :
+  m_nchare( 0 ),
+  m_aggregate( aggregate ),
+  m_async( async ),
+  m_expected( -1 ),
+  m_dump{ false, false, 0, 0, 0.0, {}, {}, {} },
+  m_postdump( 0, 0 ),
+  m_ticket( 0 ),
+  m_prevticket( 0 ),
+  m_nuse( 0 )
 // *****************************************************************************
 //  Constructor: set some defaults that stay constant at all times
+//! \param[in] aggregate True to write a single file per compute node
+//!   containing the mesh chunks and fields of all chares on the node, false
+//!   to write a file per chare
+//! \param[in] async True to write files on a background thread and continue
+//!   as soon as the data to be written is buffered
 // *****************************************************************************
 {
 }
@@ -34,6 +53,29 @@ MeshWriter::nchare( int n )
   m_nchare = n;
 }
 
+void
+MeshWriter::nodechares( int n, int count[] )
+// *****************************************************************************
+// Reduction target: number of chares writing to each compute node
+//! \param[in] n Number of compute nodes
+//! \param[in] count Number of chares writing to each compute node in the
+//!   current dump
+//! \details Broadcast to all PEs, only the first PE of each compute node,
+//!   which receives the chunks of the node, uses it. The chunks may arrive
+//!   before or after the count, so either one may complete the dump.
+// *****************************************************************************
+{
+  if (CkMyPe() != CkNodeFirst( CkMyNode() )) return;
+
+  ErrChk( n == CkNumNodes(), "Chare count size mismatch" );
+  m_expected = count[ CkMyNode() ];
+
+  if (m_expected == 0)
+    m_expected = -1;
+  else if (m_chunks.size() == static_cast< std::size_t >( m_expected ))
+    complete();
+}
+
 void
 MeshWriter::write(
   bool meshoutput,
@@ -45,6 +87,7 @@ MeshWriter::write(
   const std::string& basefilename,
   const std::vector< std::size_t >& inpoel,
   const UnsMesh::Coords& coord,
+  const std::vector< std::size_t >& gid,
   const std::map< int, std::vector< std::size_t > >& bface,
   const std::map< int, std::vector< std::size_t > >& bnode,
   const std::vector< std::size_t >& triinpoel,
@@ -69,6 +112,8 @@ MeshWriter::write(
 //! \param[in] inpoel Mesh connectivity for the mesh chunk to be written with
 //!   local ids
 //! \param[in] coord Node coordinates of the mesh chunk to be written
+//! \param[in] gid Global node ids of the mesh chunk to be written, only used
+//!   with aggregated output
 //! \param[in] bface Map of boundary-face lists mapped to corresponding side set
 //!   ids for this mesh chunk
 //! \param[in] bnode Map of boundary-node lists mapped to corresponding side set
@@ -84,15 +129,128 @@ MeshWriter::write(
 //! \param[in] outsets Unique set of surface side set ids along which to save
 //!   solution field variables
 //! \param[in] c Function to continue with after the write
+//! \details With aggregated output the chunk is only buffered and the write
+//!   is deferred until the chunks of all chares writing to this compute node
+//!   have arrived, see nodechares(). With asynchronous output the data, which
+//!   is already a copy made by the Charm++ runtime system, is handed to the
+//!   background thread and the write continues right away, so the caller may
+//!   overwrite its fields while they are being written.
+// *****************************************************************************
+{
+  if (m_aggregate) {
+    ErrChk( outsets.empty(), "Surface output is not supported with "
+                             "aggregated output" );
+    Assert( gid.size() == coord[0].size(), "Size mismatch" );
+    Assert( m_chunks.find( chareid ) == end(m_chunks),
+            "Chare " + std::to_string(chareid) + " written twice in a dump" );
+    m_dump = Dump{ meshoutput, fieldoutput, itr, itf, time, basefilename,
+                   elemfieldnames, nodefieldnames };
+    m_chunks[ chareid ] =
+      Chunk{ inpoel, coord, gid, elemfields, nodefields, c };
+    if (m_chunks.size() == static_cast< std::size_t >( m_expected ))
+      complete();
+    return;
+  }
+
+  if (m_async) {
+    post( itr, itf, [=](){
+      writeChare( meshoutput, fieldoutput, itr, itf, time, chareid,
+                  basefilename, inpoel, coord, bface, bnode, triinpoel,
+                  elemfieldnames, nodefieldnames, nodesurfnames, elemfields,
+                  nodefields, nodesurfs, outsets ); } );
+  } else {
+    writeChare( meshoutput, fieldoutput, itr, itf, time, chareid,
+                basefilename, inpoel, coord, bface, bnode, triinpoel,
+                elemfieldnames, nodefieldnames, nodesurfnames, elemfields,
+                nodefields, nodesurfs, outsets );
+  }
+
+  c.send();
+}
+
+void
+MeshWriter::flush( CkCallback c )
+// *****************************************************************************
+//  Finish all output and close all files
+//! \param[in] c Function to continue with after all output is written
+//! \details Called on all PEs, but only the first PE of each compute node
+//!   writes output. With asynchronous output the files are closed on the
+//!   background thread, which they are used on, and errors of the background
+//!   thread are reported here.
+// *****************************************************************************
+{
+  try {
+    if (m_async) {
+      if (CkMyPe() == CkNodeFirst( CkMyNode() )) {
+        auto& io = IOThread::instance();
+        io.post( [this](){ m_files.clear(); } );
+        io.drain();
+      }
+    } else {
+      m_files.clear();
+    }
+  } catch (...) { tk::processExceptionCharm(); }
+  contribute( c );
+}
+
+void
+MeshWriter::post( uint64_t itr, uint64_t itf, std::function< void() >&& job )
+// *****************************************************************************
+//  Post a file write job to the background thread
+//! \param[in] itr Iteration count since a new mesh of the dump the job writes
+//! \param[in] itf Field output iteration count of the dump the job writes
+//! \param[in] job Job writing a file, owning all data it writes
+//! \details Output is double-buffered: while a dump is being written its
+//!   successor may be buffered, but the first job of a third dump waits until
+//!   the first of the two is written. This bounds the memory held by the
+//!   background thread to two dumps, if output is faster than I/O.
+// *****************************************************************************
+{
+  auto& io = IOThread::instance();
+  std::pair< uint64_t, uint64_t > dump( itr, itf );
+  if (dump != m_postdump) {
+    io.wait( m_prevticket );
+    m_prevticket = m_ticket;
+    m_postdump = dump;
+  }
+  m_ticket = io.post( std::move(job) );
+}
+
+void
+MeshWriter::writeChare(
+  bool meshoutput,
+  bool fieldoutput,
+  uint64_t itr,
+  uint64_t itf,
+  tk::real time,
+  int chareid,
+  const std::string& basefilename,
+  const std::vector< std::size_t >& inpoel,
+  const UnsMesh::Coords& coord,
+  const std::map< int, std::vector< std::size_t > >& bface,
+  const std::map< int, std::vector< std::size_t > >& bnode,
+  const std::vector< std::size_t >& triinpoel,
+  const std::vector< std::string >& elemfieldnames,
+  const std::vector< std::string >& nodefieldnames,
+  const std::vector< std::string >& nodesurfnames,
+  const std::vector< std::vector< tk::real > >& elemfields,
+  const std::vector< std::vector< tk::real > >& nodefields,
+  const std::vector< std::vector< tk::real > >& nodesurfs,
+  const std::set< int >& outsets )
+// *****************************************************************************
+//  Write a single chare's mesh chunk and fields into its own file(s)
+//! \details See write() for the arguments. Does not call into the Charm++
+//!   runtime system, so it may be called from the background thread. The
+//!   files stay open for the field output of later dumps, see file().
 // *****************************************************************************
 {
   // Generate filenames for volume and surface field output
-  auto vf = filename( basefilename, itr, chareid );
+  auto vf = filename( basefilename, itr, m_nchare, chareid );
   
   if (meshoutput) {
 
     // Write volume mesh and field names
-    ExodusIIMeshWriter ev( vf, ExoWriter::CREATE );
+    const auto& ev = file( vf, ExoWriter::CREATE );
     // Write chare mesh (do not write side sets in parallel)
     if (m_nchare == 1) {
       ev.writeMesh( inpoel, coord, bnode );
@@ -105,8 +263,8 @@ MeshWriter::write(
 
     // Write surface meshes and surface variable field names
     for (auto s : outsets) {
-      auto sf = filename( basefilename, itr, chareid, s );
-      ExodusIIMeshWriter es( sf, ExoWriter::CREATE );
+      auto sf = filename( basefilename, itr, m_nchare, chareid, s );
+      const auto& es = file( sf, ExoWriter::CREATE );
       auto b = bface.find(s);
       if (b == end(bface)) {
         // If a side set does not exist on a chare, write out a
@@ -147,22 +305,16 @@ MeshWriter::write(
 
   if (fieldoutput) {
 
-    // Write volume variable fields
-    ExodusIIMeshWriter ev( vf, ExoWriter::OPEN );
-    ev.writeTimeStamp( itf, time );
-    // Write volume element variable fields
-    int varid = 0;
-    for (const auto& v : elemfields) ev.writeElemScalar( itf, ++varid, v );
-    // Write volume node variable fields
-    varid = 0;
-    for (const auto& v : nodefields) ev.writeNodeScalar( itf, ++varid, v );
+    // Write volume element and node variable fields
+    file( vf, ExoWriter::OPEN ).writeTimeStep( itf, time, elemfields,
+                                               nodefields );
 
     // Write surface node variable fields
     std::size_t j = 0;
     auto nvar = static_cast< int >( nodesurfnames.size() ) ;
     for (auto s : outsets) {
-      auto sf = filename( basefilename, itr, chareid, s );
-      ExodusIIMeshWriter es( sf, ExoWriter::OPEN );
+      auto sf = filename( basefilename, itr, m_nchare, chareid, s );
+      const auto& es = file( sf, ExoWriter::OPEN );
       es.writeTimeStamp( itf, time );
       if (bface.find(s) == end(bface)) {
         // If a side set does not exist on a chare, write out a
@@ -178,21 +330,150 @@ MeshWriter::write(
     }
 
   }
+}
 
-  c.send();
+void
+MeshWriter::complete()
+// *****************************************************************************
+//  Write all chunks buffered on this compute node and continue
+//! \details The buffers are reset for the next dump before continuing on the
+//!   chares whose chunks were written. With asynchronous output the chunks
+//!   are moved to the background thread and are merged and written there.
+// *****************************************************************************
+{
+  std::vector< CkCallback > cbs;
+  for (const auto& c : m_chunks) cbs.push_back( c.second.cb );
+
+  auto vf = filename( m_dump.basefilename, m_dump.itr, CkNumNodes(),
+                      CkMyNode() );
+
+  if (m_async) {
+    post( m_dump.itr, m_dump.itf,
+          [ this, vf, chunks = std::move(m_chunks), dump = m_dump ](){
+            writeAggregate( vf, chunks, dump ); } );
+  } else {
+    writeAggregate( vf, m_chunks, m_dump );
+  }
+
+  m_chunks.clear();
+  m_expected = -1;
+  for (auto& c : cbs) c.send();
+}
+
+void
+MeshWriter::writeAggregate( const std::string& vf,
+                            const std::map< int, Chunk >& chunks,
+                            const Dump& dump )
+// *****************************************************************************
+//  Merge chunks and write them into a single file
+//! \param[in] vf Name of the file to write
+//! \param[in] chunks Mesh chunks and fields associated to chare ids
+//! \param[in] dump Data of the dump that is the same for all chunks
+//! \details The chunks are merged in chare id order, so the node and element
+//!   numbering in the file does not depend on the order the chunks arrived in.
+//!   Nodes shared by chunks are only written once, identified by their global
+//!   node ids, which are also written as the node number map of the file.
+//!   Element fields are concatenated in the same order as the elements. The
+//!   file is named as if the job had one worker per compute node, so ParaView
+//!   still glues the files of all compute nodes into a single output.
+// *****************************************************************************
+{
+  // Merge chunks: renumber nodes by global id and concatenate elements
+  std::unordered_map< std::size_t, std::size_t > lid;
+  std::vector< std::size_t > gid, inpoel;
+  UnsMesh::Coords coord;
+  std::vector< std::vector< tk::real > >
+    elemfields( chunks.begin()->second.elemfields.size() ),
+    nodefields( chunks.begin()->second.nodefields.size() );
+
+  for (const auto& [ chareid, c ] : chunks) {
+    Assert( c.elemfields.size() == elemfields.size() &&
+            c.nodefields.size() == nodefields.size(),
+            "Chare " + std::to_string(chareid) + " field count mismatch" );
+    std::vector< std::size_t > map( c.gid.size() );
+    for (std::size_t i=0; i<c.gid.size(); ++i) {
+      auto [ it, added ] = lid.emplace( c.gid[i], gid.size() );
+      if (added) {
+        gid.push_back( c.gid[i] );
+        for (std::size_t d=0; d<3; ++d) coord[d].push_back( c.coord[d][i] );
+        for (std::size_t v=0; v<nodefields.size(); ++v)
+          nodefields[v].push_back( c.nodefields[v][i] );
+      }
+      map[i] = it->second;
+    }
+    for (auto p : c.inpoel) inpoel.push_back( map[p] );
+    for (std::size_t v=0; v<elemfields.size(); ++v)
+      elemfields[v].insert( end(elemfields[v]), begin(c.elemfields[v]),
+                            end(c.elemfields[v]) );
+  }
+
+  if (dump.meshoutput) {
+    const auto& ev = file( vf, ExoWriter::CREATE );
+    ev.writeMesh< 4 >( inpoel, coord );
+    ev.writeNodeIdMap( gid );
+    ev.writeElemVarNames( dump.elemfieldnames );
+    ev.writeNodeVarNames( dump.nodefieldnames );
+  }
+
+  if (dump.fieldoutput) {
+    file( vf, ExoWriter::OPEN ).writeTimeStep( dump.itf, dump.time,
+                                               elemfields, nodefields );
+  }
+}
+
+const tk::ExodusIIMeshWriter&
+MeshWriter::file( const std::string& name, ExoWriter mode )
+// *****************************************************************************
+//  Access an output file, keeping it open for later dumps
+//! \param[in] name File name
+//! \param[in] mode ExoWriter::CREATE to create a new file, replacing a file
+//!   of the same name, or ExoWriter::OPEN to append to an existing file
+//! \return ExodusII writer of the file
+//! \details Files are kept open across dumps, so the field output of a dump
+//!   does not have to reopen files and reread their metadata. If more than
+//!   m_maxfiles files would be open, the least recently used one is closed; it
+//!   is reopened if written again. Files are closed by flush().
+// *****************************************************************************
+{
+  ++m_nuse;
+
+  auto f = m_files.find( name );
+  if (f != end(m_files)) {
+    if (mode == ExoWriter::OPEN) {
+      f->second.use = m_nuse;
+      return *f->second.writer;
+    }
+    m_files.erase( f );         // close before recreating
+  }
+
+  if (m_files.size() >= m_maxfiles) {
+    auto lru = std::min_element( begin(m_files), end(m_files),
+                 []( const auto& a, const auto& b ){
+                   return a.second.use < b.second.use; } );
+    m_files.erase( lru );
+  }
+
+  auto& o = m_files[ name ];
+  o.writer = std::make_unique< ExodusIIMeshWriter >( name, mode );
+  o.use = m_nuse;
+  return *o.writer;
 }
 
 std::string
 MeshWriter::filename( const std::string& basefilename,
                       uint64_t itr,
-                      int chareid,
+                      int np,
+                      int id,
                       int surfid ) const
 // *****************************************************************************
 //  Compute filename
 //! \param[in] basefilename String use as the base filename.
 //! \param[in] itr Iteration count since a new mesh. New mesh in this context
 //!   means that either the mesh is moved and/or its topology has changed.
-//! \param[in] chareid The chare id the write-to-file request is coming from
+//! \param[in] np Total number of files written per output, i.e., the number
+//!   of chares, or the number of compute nodes with aggregated output
+//! \param[in] id The chare id the write-to-file request is coming from, or the
+//!   compute node id with aggregated output
 //! \param[in] surfid Surface ID if computing a surface filename
 //! \details We use a file naming convention for large field output data that
 //!   allows ParaView to glue multiple files into a single simulation output by
@@ -216,8 +497,8 @@ MeshWriter::filename( const std::string& basefilename,
   return basefilename + (surfid ? "-surf." + std::to_string(surfid) : "")
          + ".e-s"
          + '.' + std::to_string( itr )        // iteration count with new mesh
-         + '.' + std::to_string( m_nchare )   // total number of workers
-         + '.' + std::to_string( chareid );   // new file per worker
+         + '.' + std::to_string( np )         // total number of workers
+         + '.' + std::to_string( id );        // new file per worker
 }
 
 #include "NoWarning/meshwriter.def.h"
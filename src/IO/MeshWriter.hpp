@@ -13,8 +13,15 @@
 #ifndef MeshWriter_h
 #define MeshWriter_h
 
+#include <map>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <functional>
+
 #include "Types.hpp"
 #include "UnsMesh.hpp"
+#include "ExodusIIMeshWriter.hpp"
 
 #include "NoWarning/meshwriter.decl.h"
 
@@ -25,14 +32,16 @@ class MeshWriter : public CBase_MeshWriter {
 
   public:
     //! Constructor: set some defaults that stay constant at all times
-    MeshWriter();
+    explicit MeshWriter( bool aggregate, bool async );
 
     #if defined(__clang__)
       #pragma clang diagnostic push
       #pragma clang diagnostic ignored "-Wundefined-func-template"
     #endif
     //! Migrate constructor
-    explicit MeshWriter( CkMigrateMessage* m ) : CBase_MeshWriter( m ) {}
+    explicit MeshWriter( CkMigrateMessage* m ) : CBase_MeshWriter( m ),
+      m_expected( -1 ), m_postdump( 0, 0 ), m_ticket( 0 ), m_prevticket( 0 ),
+      m_nuse( 0 ) {}
     #if defined(__clang__)
       #pragma clang diagnostic pop
     #endif
@@ -40,6 +49,9 @@ class MeshWriter : public CBase_MeshWriter {
     //! Set the total number of chares
     void nchare( int n );
 
+    //! Reduction target: number of chares writing to each compute node
+    void nodechares( int n, int count[] );
+
     //! Output unstructured mesh into file
     void write( bool meshoutput,
                 bool fieldoutput,
@@ -50,6 +62,7 @@ class MeshWriter : public CBase_MeshWriter {
                 const std::string& basefilename,
                 const std::vector< std::size_t >& inpoel,
                 const UnsMesh::Coords& coord,
+                const std::vector< std::size_t >& gid,
                 const std::map< int, std::vector< std::size_t > >& bface,
                 const std::map< int, std::vector< std::size_t > >& bnode,
                 const std::vector< std::size_t >& triinpoel,
@@ -62,14 +75,23 @@ class MeshWriter : public CBase_MeshWriter {
                 const std::set< int >& outsets,
                 CkCallback c );
 
+    //! Finish all output and close all files
+    void flush( CkCallback c );
+
     /** @name Charm++ pack/unpack serializer member functions */
     ///@{
     //! \brief Pack/Unpack serialize member function
     //! \param[in,out] p Charm++'s PUP::er serializer object reference
     //! \note This is a Charm++ group, pup() is thus only for
     //!    checkpoint/restart.
+    //! \note Chunks are only buffered and asynchronous output only pending
+    //!    while a dump is in progress, when no checkpoint is taken, so they
+    //!    are not serialized. Open files are not serialized either, they are
+    //!    reopened as needed.
     void pup( PUP::er &p ) override {
       p | m_nchare;
+      p | m_aggregate;
+      p | m_async;
     }
     //! \brief Pack/Unpack serialize operator|
     //! \param[in,out] p Charm++'s PUP::er serializer object reference
@@ -78,12 +100,98 @@ class MeshWriter : public CBase_MeshWriter {
     //@}
 
   private:
+    //! Mesh chunk and field data of a chare buffered for aggregated output
+    struct Chunk {
+      std::vector< std::size_t > inpoel;                //!< Local connectivity
+      UnsMesh::Coords coord;                            //!< Node coordinates
+      std::vector< std::size_t > gid;                   //!< Global node ids
+      std::vector< std::vector< tk::real > > elemfields;  //!< Element fields
+      std::vector< std::vector< tk::real > > nodefields;  //!< Node fields
+      CkCallback cb;                                    //!< Continue after dump
+    };
+
+    //! Dump data that is the same for all chunks of a dump
+    struct Dump {
+      bool meshoutput;                          //!< True if writing the mesh
+      bool fieldoutput;                         //!< True if writing fields
+      uint64_t itr;                             //!< Mesh iteration count
+      uint64_t itf;                             //!< Field output count
+      tk::real time;                            //!< Physical time
+      std::string basefilename;                 //!< Base filename
+      std::vector< std::string > elemfieldnames;  //!< Element field names
+      std::vector< std::string > nodefieldnames;  //!< Node field names
+    };
+
     int m_nchare;       //!< Total number chares across the whole problem
+    //! True to write a single file per compute node instead of one per chare
+    bool m_aggregate;
+    //! True to write files on a background thread, see IOThread
+    bool m_async;
+    //! Number of chares writing to this compute node in the current dump,
+    //! negative if not yet known
+    int m_expected;
+    //! Chunks buffered for the current aggregated dump associated to chare ids
+    std::map< int, Chunk > m_chunks;
+    //! Data of the current aggregated dump
+    Dump m_dump;
+    //! Mesh and field iteration count of the dump posted last asynchronously
+    std::pair< uint64_t, uint64_t > m_postdump;
+    //! Ticket of the last job posted of the dump posted last
+    uint64_t m_ticket;
+    //! Ticket of the last job posted of the dump before the one posted last
+    uint64_t m_prevticket;
+    //! Output file kept open across dumps
+    struct OpenFile {
+      std::unique_ptr< ExodusIIMeshWriter > writer;     //!< ExodusII writer
+      uint64_t use;                                     //!< Last use
+    };
+    //! Output files kept open associated to file names
+    std::map< std::string, OpenFile > m_files;
+    //! Number of file accesses, used to find the least recently used file
+    uint64_t m_nuse;
+    //! Maximum number of output files kept open
+    static constexpr std::size_t m_maxfiles = 256;
+
+    //! Write all chunks buffered on this compute node and continue
+    void complete();
+
+    //! Write a single chare's mesh chunk and fields into its own file(s)
+    void writeChare( bool meshoutput,
+                     bool fieldoutput,
+                     uint64_t itr,
+                     uint64_t itf,
+                     tk::real time,
+                     int chareid,
+                     const std::string& basefilename,
+                     const std::vector< std::size_t >& inpoel,
+                     const UnsMesh::Coords& coord,
+                     const std::map< int, std::vector< std::size_t > >& bface,
+                     const std::map< int, std::vector< std::size_t > >& bnode,
+                     const std::vector< std::size_t >& triinpoel,
+                     const std::vector< std::string >& elemfieldnames,
+                     const std::vector< std::string >& nodefieldnames,
+                     const std::vector< std::string >& nodesurfnames,
+                     const std::vector< std::vector< tk::real > >& elemfields,
+                     const std::vector< std::vector< tk::real > >& nodefields,
+                     const std::vector< std::vector< tk::real > >& nodesurfs,
+                     const std::set< int >& outsets );
+
+    //! Merge chunks and write them into a single file
+    void writeAggregate( const std::string& vf,
+                         const std::map< int, Chunk >& chunks,
+                         const Dump& dump );
+
+    //! Access an output file, keeping it open for later dumps
+    const ExodusIIMeshWriter& file( const std::string& name, ExoWriter mode );
+
+    //! Post a file write job to the background thread
+    void post( uint64_t itr, uint64_t itf, std::function< void() >&& job );
 
     //! Compute filename
     std::string filename( const std::string& basefilename,
                           uint64_t itr,
-                          int chareid,
+                          int np,
+                          int id,
                           int surfid = 0 ) const;
 };
 
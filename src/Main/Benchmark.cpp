@@ -0,0 +1,336 @@
+// *****************************************************************************
+/*!
+  \file      src/Main/Benchmark.cpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Microbenchmarks of transfer kernels, Charm++ main chare.
+  \details   Microbenchmarks of transfer kernels, Charm++ main chare. This
+    executable times the kernels of the mesh-to-mesh transfer and of mesh
+    setup in isolation, on synthetic inputs of controllable size, and reports
+    their throughput, so kernel optimizations can be judged quickly. Charm++'s
+    startup is not timed and the executable can be run without charmrun, e.g.,
+    on a single core. Usage:
+
+      m2mbench [-n cells] [-reps r] [-jitter f]
+
+    -n       Number of hexahedral cells of the synthetic box mesh in each
+             direction, each split into 6 tetrahedra (default: 32)
+    -reps    Number of repetitions of each kernel, the fastest is reported
+             (default: 5)
+    -jitter  Random perturbation of the interior nodes of the synthetic mesh
+             as a fraction of the cell size (default: 0.1)
+
+    Kernels benchmarked:
+    - intet: point-in-tetrahedron test and shapefunctions, exam2m::intet
+    - incell-tet, incell-hex: point-in-cell test and shapefunctions by
+      inverting the isoparametric map, exam2m::incell, on the tetrahedra and
+      on the (trilinear) hexahedral cells of the synthetic mesh
+    - separate: separating potential collisions by the mesh chares they belong
+      to, exam2m::separateCollisions, for both the Collision and the
+      DetailedCollision overloads
+    - global2local: tk::global2local on a chunk with scattered global node ids
+    - esup, esuel: tk::genEsup and tk::genEsuelTet, as well as the node-parallel
+      tk::genEsupPar and tk::genEsuelTetPar
+    - readNodes: tk::ExodusIIMeshReader::readNodes on a file written from the
+      synthetic mesh
+*/
+// *****************************************************************************
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+#include "Types.hpp"
+#include "Timer.hpp"
+#include "Exception.hpp"
+#include "ProcessException.hpp"
+#include "Generator.hpp"
+#include "DerivedData.hpp"
+#include "Reorder.hpp"
+#include "ContainerUtil.hpp"
+#include "ExodusIIMeshWriter.hpp"
+#include "ExodusIIMeshReader.hpp"
+#include "Controller.hpp"
+#include "Interpolate.hpp"
+#include "ParallelFor.hpp"
+#include "NoWarning/charm.hpp"
+
+#include "NoWarning/benchmark.decl.h"
+
+namespace {
+
+//! Time a kernel, taking the fastest of a number of repetitions
+//! \param[in] reps Number of repetitions
+//! \param[in] kernel Kernel to time
+//! \return Wall-clock time of the fastest repetition in seconds
+template< class Kernel >
+tk::real timeKernel( std::size_t reps, Kernel&& kernel ) {
+  tk::real best = 0.0;
+  for (std::size_t r=0; r<reps; ++r) {
+    tk::Timer t;
+    kernel();
+    auto dt = t.dsec();
+    if (r == 0 || dt < best) best = dt;
+  }
+  return best;
+}
+
+//! Output throughput of a kernel
+//! \param[in] name Kernel name
+//! \param[in] n Number of items processed by the kernel
+//! \param[in] unit Items processed by the kernel
+//! \param[in] t Wall-clock time of the kernel in seconds
+void report( const char* name, std::size_t n, const char* unit, tk::real t ) {
+  CkPrintf( "Bench> %-14s %12zu %-10s in %10.6f sec: %12.4e %s/s\n", name, n,
+            unit, t, static_cast< tk::real >( n ) / t, unit );
+}
+
+} // ::
+
+//! Charm++ main chare for the m2mbench executable.
+class Benchmark : public CBase_Benchmark {
+
+  public:
+    //! Constructor: parse command line arguments
+    Benchmark( CkArgMsg* msg )
+    try :
+      m_signal( tk::setSignalHandlers() ),
+      m_n( 32 ),
+      m_reps( 5 ),
+      m_jitter( 0.1 )
+    {
+      for (int i=1; i<msg->argc; ++i) {
+        std::string flag( msg->argv[i] );
+        ErrChk( i+1 < msg->argc, "Missing value for argument " + flag );
+        std::stringstream arg( msg->argv[++i] );
+        if (flag == "-n") arg >> m_n;
+        else if (flag == "-reps") arg >> m_reps;
+        else if (flag == "-jitter") arg >> m_jitter;
+        else Throw( "Unknown argument: " + flag );
+        ErrChk( !arg.fail(), "Invalid value for argument " + flag );
+      }
+      delete msg;
+      ErrChk( m_n > 0 && m_reps > 0, "Mesh size and repetitions must be > 0" );
+
+      // Initialize CkLoop used by tk::parallelFor on the worker threads, unless
+      // already done by the transfer library's main chare
+      tk::initParallelFor();
+
+      thisProxy.run();
+    } catch (...) { tk::processExceptionCharm(); }
+
+    //! Migrate constructor
+    explicit Benchmark( CkMigrateMessage* msg ) : CBase_Benchmark( msg ),
+      m_signal( tk::setSignalHandlers() ) {}
+
+    //! Run all benchmarks and exit
+    void run() {
+      try {
+        std::vector< std::size_t > inpoel;
+        tk::UnsMesh::Coords coord;
+        tk::genBoxMesh( {{ m_n, m_n, m_n }}, {{ 0.0, 1.0, 0.0, 1.0, 0.0, 1.0 }},
+                        m_jitter, 0, inpoel, coord );
+        const auto nelem = inpoel.size()/4;
+        const auto npoin = coord[0].size();
+        CkPrintf( "Bench> Synthetic mesh: %zu tetrahedra, %zu nodes, "
+                  "fastest of %zu repetitions, %zu PE(s) per node\n", nelem,
+                  npoin, m_reps, tk::parallelWidth() );
+
+        benchIntet( inpoel, coord );
+        benchIncell( "incell-tet", inpoel, 4, coord );
+        benchIncell( "incell-hex", tk::genBoxHexes( {{ m_n, m_n, m_n }} ), 8,
+                     coord );
+        benchSeparate( nelem );
+        benchDerivedData( inpoel, npoin );
+        benchReadNodes( inpoel, coord );
+
+        CkExit();
+      } catch (...) { tk::processExceptionCharm(); }
+    }
+
+  private:
+    int m_signal;               //!< Used to set signal handlers
+    std::size_t m_n;            //!< Number of cells in each direction
+    std::size_t m_reps;         //!< Number of repetitions of each kernel
+    tk::real m_jitter;          //!< Node perturbation / cell size
+
+    //! Benchmark point-in-tetrahedron test
+    //! \param[in] inpoel Element connectivity
+    //! \param[in] coord Node coordinates
+    //! \details Each tetrahedron is tested with its own centroid (a hit) and
+    //!   with the centroid of a tetrahedron in a different cell (a miss).
+    void benchIntet( const std::vector< std::size_t >& inpoel,
+                     const tk::UnsMesh::Coords& coord ) const
+    {
+      const auto nelem = inpoel.size()/4;
+      std::vector< tk::lindex > linpoel( begin(inpoel), end(inpoel) );
+      std::vector< std::array< tk::real, 3 > > cen( nelem );
+      for (std::size_t e=0; e<nelem; ++e)
+        for (std::size_t d=0; d<3; ++d)
+          cen[e][d] = ( coord[d][inpoel[e*4+0]] + coord[d][inpoel[e*4+1]] +
+                        coord[d][inpoel[e*4+2]] + coord[d][inpoel[e*4+3]] ) / 4;
+
+      std::size_t hits = 0;
+      tk::real sum = 0.0;
+      auto t = timeKernel( m_reps, [&](){
+        std::array< tk::real, 4 > N;
+        hits = 0;
+        for (std::size_t e=0; e<nelem; ++e) {
+          if (exam2m::intet( linpoel, coord, cen[e], e, N )) {
+            ++hits;
+            sum += N[0];
+          }
+          if (exam2m::intet( linpoel, coord, cen[(e+nelem/2+6)%nelem], e, N ))
+            ++hits;
+        }
+      } );
+      report( "intet", 2*nelem, "points", t );
+      CkPrintf( "Bench> %-14s hits: %zu, checksum: %g\n", "intet", hits, sum );
+    }
+
+    //! Benchmark point-in-cell test by inverting the isoparametric map
+    //! \param[in] name Kernel name
+    //! \param[in] inpoel Element connectivity
+    //! \param[in] nnpe Number of nodes per element
+    //! \param[in] coord Node coordinates
+    //! \details Each cell is tested with its own centroid (a hit) and with the
+    //!   centroid of a different cell (a miss), as in benchIntet().
+    void benchIncell( const char* name,
+                      const std::vector< std::size_t >& inpoel,
+                      std::size_t nnpe,
+                      const tk::UnsMesh::Coords& coord ) const
+    {
+      const auto nelem = inpoel.size()/nnpe;
+      std::vector< tk::lindex > linpoel( begin(inpoel), end(inpoel) );
+      std::vector< std::array< tk::real, 3 > > cen( nelem );
+      for (std::size_t e=0; e<nelem; ++e)
+        for (std::size_t d=0; d<3; ++d) {
+          cen[e][d] = 0.0;
+          for (std::size_t j=0; j<nnpe; ++j)
+            cen[e][d] += coord[d][inpoel[e*nnpe+j]];
+          cen[e][d] /= static_cast< tk::real >( nnpe );
+        }
+
+      std::size_t hits = 0;
+      tk::real sum = 0.0;
+      auto t = timeKernel( m_reps, [&](){
+        std::array< tk::real, exam2m::MAX_NNPE > N;
+        hits = 0;
+        for (std::size_t e=0; e<nelem; ++e) {
+          if (exam2m::incell( linpoel, e*nnpe, nnpe, coord, cen[e], N )) {
+            ++hits;
+            sum += N[0];
+          }
+          if (exam2m::incell( linpoel, e*nnpe, nnpe, coord,
+                              cen[(e+nelem/2+6)%nelem], N ))
+            ++hits;
+        }
+      } );
+      report( name, 2*nelem, "points", t );
+      CkPrintf( "Bench> %-14s hits: %zu, checksum: %g\n", name, hits, sum );
+    }
+
+    //! Benchmark separating collisions by mesh chares
+    //! \param[in] nelem Number of elements, used to size the collision list
+    //! \details Emulates collisions between 64 destination and 64 source mesh
+    //!   chares, four potential collisions per element.
+    void benchSeparate( std::size_t nelem ) const
+    {
+      const int nchare = 64;
+      exam2m::MeshMap meshes;
+      meshes[0].m_firstchunk = 0;
+      meshes[0].m_nchare = nchare;
+      meshes[0].dest = true;
+      meshes[1].m_firstchunk = nchare;
+      meshes[1].m_nchare = nchare;
+      meshes[1].dest = false;
+
+      const auto ncoll = nelem*4;
+      std::vector< Collision > colls;
+      colls.reserve( ncoll );
+      for (std::size_t i=0; i<ncoll; ++i) {
+        auto n = static_cast< int >( i );
+        colls.emplace_back(
+          CollideObjID( n % nchare, n / nchare, 1, 0 ),
+          CollideObjID( nchare + (n / 7) % nchare, n / 3, 0, 0 ) );
+      }
+
+      exam2m::MeshDict dest;
+      auto t = timeKernel( m_reps, [&](){
+        dest.clear();
+        exam2m::separateCollisions( meshes, dest, true,
+          static_cast< int >( ncoll ), colls.data() );
+      } );
+      report( "separate", ncoll, "colls", t );
+
+      std::vector< exam2m::DetailedCollision > detailed;
+      for (const auto& m : dest)
+        for (const auto& c : m.second)
+          detailed.insert( end(detailed), begin(c), end(c) );
+      exam2m::MeshDict source;
+      t = timeKernel( m_reps, [&](){
+        source.clear();
+        exam2m::separateCollisions( meshes, source, false,
+          static_cast< int >( detailed.size() ), detailed.data() );
+      } );
+      report( "separate-det", detailed.size(), "colls", t );
+    }
+
+    //! Benchmark generating derived data structures
+    //! \param[in] inpoel Element connectivity
+    //! \param[in] npoin Number of nodes
+    void benchDerivedData( const std::vector< std::size_t >& inpoel,
+                           std::size_t npoin ) const
+    {
+      const auto nelem = inpoel.size()/4;
+
+      // Scatter node ids, as global ids of a mesh chunk would be, by a
+      // random permutation, seeded for reproducible timings
+      std::vector< std::size_t > gid( npoin );
+      std::iota( begin(gid), end(gid), npoin );
+      std::shuffle( begin(gid), end(gid), std::mt19937_64( 7919 ) );
+      std::vector< std::size_t > ginpoel( inpoel.size() );
+      for (std::size_t i=0; i<inpoel.size(); ++i) ginpoel[i] = gid[ inpoel[i] ];
+      auto t = timeKernel( m_reps, [&](){ tk::global2local( ginpoel ); } );
+      report( "global2local", nelem, "elements", t );
+
+      std::pair< std::vector< std::size_t >, std::vector< std::size_t > > esup;
+      t = timeKernel( m_reps, [&](){ esup = tk::genEsup( inpoel, 4 ); } );
+      report( "esup", nelem, "elements", t );
+      t = timeKernel( m_reps, [&](){ esup = tk::genEsupPar( inpoel, 4 ); } );
+      report( "esup-par", nelem, "elements", t );
+
+      t = timeKernel( m_reps, [&](){ tk::genEsuelTet( inpoel, esup ); } );
+      report( "esuel", nelem, "elements", t );
+      t = timeKernel( m_reps, [&](){ tk::genEsuelTetPar( inpoel, esup ); } );
+      report( "esuel-par", nelem, "elements", t );
+    }
+
+    //! Benchmark reading node coordinates from file
+    //! \param[in] inpoel Element connectivity
+    //! \param[in] coord Node coordinates
+    void benchReadNodes( const std::vector< std::size_t >& inpoel,
+                         const tk::UnsMesh::Coords& coord ) const
+    {
+      const std::string file( "m2mbench.exo" );
+      tk::ExodusIIMeshWriter( file, tk::ExoWriter::CREATE ).
+        writeMesh< 4 >( inpoel, coord );
+
+      // Read the nodes of the first half of the elements, as a mesh chunk
+      std::vector< std::size_t > gid( begin(inpoel),
+                                      begin(inpoel) + inpoel.size()/2 );
+      tk::unique( gid );
+      tk::ExodusIIMeshReader er( file );
+      auto t = timeKernel( m_reps, [&](){ er.readNodes( gid ); } );
+      report( "readNodes", gid.size(), "nodes", t );
+
+      std::remove( file.c_str() );
+    }
+};
+
+#include "NoWarning/benchmark.def.h"
@@ -0,0 +1,76 @@
+// *****************************************************************************
+/*!
+  \file      src/Main/CellArray.cpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     CellArray chare array holding part of a mesh of source cells
+  \details   CellArray chare array holding part of a mesh of volume cells of
+             mixed type.
+*/
+// *****************************************************************************
+
+#include <limits>
+
+#include "CellArray.hpp"
+#include "Exception.hpp"
+
+using exam2m::CellArray;
+
+CellArray::CellArray( const tk::UnsMesh::Coords& coord,
+                      const std::vector< std::size_t >& inpoel,
+                      const std::vector< std::size_t >& cellptr,
+                      CkCallback created ) :
+  m_coord( coord ),
+  m_inpoel( inpoel.size() ),
+  m_cellptr( cellptr ),
+  m_u( coord[0].size(), 1 ),
+  m_none()
+// *****************************************************************************
+//  Constructor
+//! \param[in] coord Coordinates of the nodes of the cells of this chare
+//! \param[in] inpoel Connectivity of the cells of this chare, the nodes of
+//!   each cell in ExodusII order, using the local ids of the nodes in coord
+//! \param[in] cellptr Offsets of the cells in inpoel, one more than cells
+//! \param[in] created Callback to contribute to once created
+// *****************************************************************************
+{
+  Assert( cellptr.size() > 1, "No cells assigned to CellArray chare" );
+  ErrChk( m_coord[0].size() <= std::numeric_limits< tk::lindex >::max(),
+          "Too many cell nodes for the local index type, reconfigure with "
+          "-DLOCAL_INDEX=64 or use more chares" );
+
+  for (std::size_t i=0; i<inpoel.size(); ++i)
+    m_inpoel[i] = static_cast< tk::lindex >( inpoel[i] );
+
+  contribute( created );
+}
+
+void
+CellArray::setSolution( Solution& s, CkCallback cb )
+// *****************************************************************************
+//  Set the solution at the nodes of the cells
+//! \param[in] s Solution to evaluate at the nodes
+//! \param[in] cb Callback to contribute to once set
+// *****************************************************************************
+{
+  for (std::size_t i=0; i<m_coord[0].size(); ++i)
+    m_u(i,0,0) = s.f( m_coord[0][i], m_coord[1][i], m_coord[2][i] );
+
+  contribute( cb );
+}
+
+void
+CellArray::transferSource( bool source )
+// *****************************************************************************
+//  Take part in a transfer, as its source or with no cells
+//! \param[in] source True if the cells are the source of the transfer
+//! \details All chares bound to the transfer library take part in each of
+//!   its collision detection steps, so the cells are registered as a source
+//!   of no cells while other meshes transfer.
+// *****************************************************************************
+{
+  exam2m::setSourceCells( thisProxy, thisIndex, &m_inpoel, &m_cellptr,
+                          &m_coord, m_u, source ? nullptr : &m_none );
+}
+
+#include "NoWarning/cellarray.def.h"
@@ -0,0 +1,87 @@
+// *****************************************************************************
+/*!
+  \file      src/Main/CellArray.hpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Chare class declaration for cellarrays holding source cells
+  \details   Chare class declaration for cellarrays holding part of a mesh of
+     volume cells of mixed type, e.g., hexahedra, prisms, and pyramids, whose
+     solution is transferred by the transfer library into the meshes. Unlike
+     a mesh, the cells are only a source, so they need no partitioning or
+     communication maps, and are distributed to chares in the order given.
+*/
+// *****************************************************************************
+#ifndef CellArray_h
+#define CellArray_h
+
+#include "Types.hpp"
+#include "PUPUtil.hpp"
+#include "UnsMesh.hpp"
+#include "Fields.hpp"
+#include "Controller.hpp"
+#include "MeshArray.hpp"
+
+#include "NoWarning/cellarray.decl.h"
+
+namespace exam2m {
+
+//! CellArray chare array holding part of a mesh of cells of mixed type
+class CellArray : public CBase_CellArray {
+
+  public:
+    //! Constructor
+    explicit CellArray( const tk::UnsMesh::Coords& coord,
+                        const std::vector< std::size_t >& inpoel,
+                        const std::vector< std::size_t >& cellptr,
+                        CkCallback created );
+
+    #if defined(__clang__)
+      #pragma clang diagnostic push
+      #pragma clang diagnostic ignored "-Wundefined-func-template"
+    #endif
+    //! Migrate constructor
+    // cppcheck-suppress uninitMemberVar
+    explicit CellArray( CkMigrateMessage* ) {}
+    #if defined(__clang__)
+      #pragma clang diagnostic pop
+    #endif
+
+    //! Set the solution at the nodes of the cells
+    void setSolution( Solution& s, CkCallback cb );
+
+    //! Take part in a transfer, as its source or with no cells
+    void transferSource( bool source );
+
+    /** @name Charm++ pack/unpack serializer member functions */
+    ///@{
+    //! \brief Pack/Unpack serialize member function
+    //! \param[in,out] p Charm++'s PUP::er serializer object reference
+    void pup( PUP::er &p ) override {
+      p | m_coord;
+      p | m_inpoel;
+      p | m_cellptr;
+      p | m_u;
+      p | m_none;
+    }
+    //! \brief Pack/Unpack serialize operator|
+    //! \param[in,out] p Charm++'s PUP::er serializer object reference
+    //! \param[in,out] i CellArray object reference
+    friend void operator|( PUP::er& p, CellArray& i ) { i.pup(p); }
+    //@}
+
+  private:
+    //! Node coordinates of the cells
+    tk::UnsMesh::Coords m_coord;
+    //! Connectivity of the cells, the nodes of each cell in ExodusII order
+    std::vector< tk::lindex > m_inpoel;
+    //! Offsets of the cells in m_inpoel, one more than cells
+    std::vector< std::size_t > m_cellptr;
+    //! Solution at the nodes of the cells
+    tk::Fields m_u;
+    //! Empty list of cells to transfer from while not the source
+    std::vector< tk::lindex > m_none;
+};
+
+} // exam2m::
+
+#endif // CellArray_h
@@ -8,10 +8,20 @@
 */
 // *****************************************************************************
 
+#include <cstring>
+#include <fstream>
+#include <sstream>
 #include <iostream>
+#include <array>
+#include <numeric>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
 
 #include "Driver.hpp"
 #include "MeshArray.hpp"
+#include "ProbeArray.hpp"
+#include "CellArray.hpp"
 #include "ExodusIIMeshReader.hpp"
 #include "LoadDistributor.hpp"
 
@@ -24,12 +34,33 @@ namespace exam2m {
 extern tk::real g_virtualization;
 extern int g_totaliter;
 extern int g_mode;
+extern bool g_loadbalance;
+extern bool g_reuseweights;
+extern std::string g_planprefix;
+extern std::string g_fieldname;
+extern bool g_nodeoutput;
+extern bool g_asyncoutput;
+extern bool g_surface;
+extern tk::real g_surfacetol;
+extern std::vector< tk::real > g_region;
+extern std::vector< int > g_regionsets;
+extern std::string g_probefile;
+extern tk::real g_chareoverhead;
+extern int g_cellfield;
+extern bool g_contained;
+extern std::string g_cellfile;
+extern std::string g_timingsfile;
+extern std::string g_diagfile;
+extern int g_diagtopn;
 
 }
 
 using exam2m::Driver;
 
-Driver::Driver()
+Driver::Driver() :
+  m_curriter( 0 ), m_ntransfer( 0 ), m_plan( false ), m_nstep( 0 ),
+  m_varid( 0 ), m_nprobe( 0 ), m_nprobechare( 0 ), m_ncell( 0 ),
+  m_ncellchare( 0 )
 // *****************************************************************************
 //  Constructor
 // *****************************************************************************
@@ -56,6 +87,7 @@ void Driver::initMeshData( const std::string& file )
 
   MeshData mesh;
   auto meshid = static_cast< unsigned short > ( m_meshes.size() );
+  mesh.m_file = file;
 
   // Create ExodusII mesh file reader
   tk::ExodusIIMeshReader mr( file );
@@ -98,8 +130,11 @@ void Driver::initMeshData( const std::string& file )
   cbw.get<tag::solutionfound>().setRefnum(meshid);
   cbw.get<tag::written>().setRefnum(meshid);
 
-  // Create MeshWriter chare group
-  mesh.m_meshwriter = tk::CProxy_MeshWriter::ckNew();
+  // Create MeshWriter chare group. Remapping (mode 4) always writes on the
+  // background I/O thread, since that also reads the next time step, and
+  // ExodusII must not be called from two threads at the same time.
+  mesh.m_meshwriter =
+    tk::CProxy_MeshWriter::ckNew( g_nodeoutput, g_asyncoutput || g_mode == 4 );
 
   // Create empty Mappers, will setup communication maps
   mesh.m_mapper = CProxy_Mapper::ckNew();
@@ -126,19 +161,265 @@ Driver::updatenelems( std::size_t meshid, std::size_t nelem )
   MeshData& mesh = m_meshes[meshid];
   mesh.m_nelem = nelem;
 
-  // Compute load distribution given total work (nelem) and virtualization
+  // Compute load distribution given total work (nelem) and virtualization,
+  // or, if virtualization is negative, given the work of all meshes sharing
+  // the PEs and the overhead of a chare
   uint64_t chunksize, remainder;
-  mesh.m_nchare = static_cast< int >(
-               tk::linearLoadDistributor( g_virtualization,
-                 nelem, CkNumPes(), chunksize, remainder ) );
+  if (g_virtualization < 0.0) {
+    uint64_t total = 0;
+    for (const auto& m : m_meshes) total += m.m_nelem;
+    mesh.m_nchare = static_cast< int >(
+                 tk::autoLoadDistributor( nelem, total, CkNumPes(),
+                   g_chareoverhead, chunksize, remainder ) );
+  } else {
+    mesh.m_nchare = static_cast< int >(
+                 tk::linearLoadDistributor( g_virtualization,
+                   nelem, CkNumPes(), chunksize, remainder ) );
+  }
 
   // Print out info on load distribution
   std::cout << "Initial load distribution for mesh " << meshid << "\n";
-  std::cout << "Virtualization [0.0...1.0]: " << g_virtualization << '\n';
+  if (g_virtualization < 0.0)
+    std::cout << "Virtualization: auto, chare overhead: " << g_chareoverhead
+              << " cells\n";
+  else
+    std::cout << "Virtualization [0.0...1.0]: " << g_virtualization << '\n';
   std::cout << "Number of work units: " << mesh.m_nchare << '\n';
 
   // Tell the meshwriter the total number of chares
   mesh.m_meshwriter.nchare( mesh.m_nchare );
 }
 
+CmiUInt8
+Driver::planKey() const
+// *****************************************************************************
+// Compute the key of the transfer plan between all meshes
+//! \return Key of the transfer plan from the content hashes and the number of
+//!   chares of all meshes, the tolerance of a surface transfer, the region of
+//!   interest, and the location of the field transferred
+// *****************************************************************************
+{
+  std::uint64_t key = 0;
+  for (const auto& m : m_meshes)
+    key = exam2m::planKey( key, m.m_hash, m.m_nchare );
+  if (g_surface) {
+    std::uint64_t tol;
+    static_assert( sizeof(tol) == sizeof(g_surfacetol), "Size mismatch" );
+    std::memcpy( &tol, &g_surfacetol, sizeof(tol) );
+    key = exam2m::planKey( key, tol, 0 );
+  }
+  for (auto r : g_region) {
+    std::uint64_t b;
+    std::memcpy( &b, &r, sizeof(b) );
+    key = exam2m::planKey( key, b, 1 );
+  }
+  for (auto s : g_regionsets)
+    key = exam2m::planKey( key, static_cast< std::uint64_t >( s ), 2 );
+  if (g_cellfield >= 0)
+    key = exam2m::planKey( key,
+            static_cast< std::uint64_t >( g_cellfield ), 3 );
+  return key;
+}
+
+void
+Driver::queryFields()
+// *****************************************************************************
+// Find the time steps and the nodal field of the source to remap
+//! \details The source mesh file, the first mesh, is also the results file
+//!   whose time steps are remapped. All of its time steps are remapped, or at
+//!   most as many as the iteration count, if positive. The nodal variable
+//!   remapped is the one given by +m2m_field, or the first one.
+// *****************************************************************************
+{
+  tk::ExodusIIMeshReader er( m_meshes[0].m_file );
+
+  m_steptimes = er.readTimeValues();
+  if (g_totaliter > 0 &&
+      m_steptimes.size() > static_cast< std::size_t >( g_totaliter ))
+    m_steptimes.resize( static_cast< std::size_t >( g_totaliter ) );
+  m_nstep = static_cast< int >( m_steptimes.size() );
+  ErrChk( m_nstep > 0, "No time steps to remap in " + m_meshes[0].m_file );
+
+  auto names = er.readNodeVarNames();
+  ErrChk( !names.empty(), "No nodal variables to remap in " +
+                          m_meshes[0].m_file );
+  m_varid = 1;
+  if (!g_fieldname.empty()) {
+    auto n = std::find( begin(names), end(names), g_fieldname );
+    ErrChk( n != end(names), "Nodal variable '" + g_fieldname + "' not found "
+                             "in " + m_meshes[0].m_file );
+    m_varid = static_cast< int >( n - begin(names) ) + 1;
+  }
+
+  CkPrintf( "ExaM2M> Remapping nodal variable '%s' of %i time step(s) of %s\n",
+            names[ static_cast< std::size_t >( m_varid-1 ) ].c_str(), m_nstep,
+            m_meshes[0].m_file.c_str() );
+}
+
+void
+Driver::initProbes()
+// *****************************************************************************
+// Read the probe points and distribute them to a new ProbeArray
+//! \details The probe points are read from the file given by +m2m_probes, with
+//!   the coordinates of a point per line, skipping empty lines and lines
+//!   starting with '#'. They are sorted along a Morton (Z-order) curve and
+//!   divided among a chare per PE in that order, as probes need neither
+//!   partitioning nor communication maps. This keeps the points of a chare
+//!   close to each other, so each chare's points overlap few source mesh
+//!   chares, independent of the order the points are given in.
+// *****************************************************************************
+{
+  std::ifstream f( g_probefile );
+  ErrChk( f.good(), "Failed to open probe file " + g_probefile );
+
+  tk::UnsMesh::Coords coord;
+  std::string line;
+  while (std::getline( f, line )) {
+    if (line.empty() || line[0] == '#') continue;
+    std::stringstream ss( line );
+    tk::real x, y, z;
+    ErrChk( static_cast< bool >( ss >> x >> y >> z ),
+            "Invalid probe point in " + g_probefile + ": " + line );
+    coord[0].push_back( x );
+    coord[1].push_back( y );
+    coord[2].push_back( z );
+  }
+  m_nprobe = coord[0].size();
+  ErrChk( m_nprobe > 0, "No probe points in " + g_probefile );
+
+  // Morton key of each point: its coordinates, quantized to 21 bits within
+  // the bounding box of all points, with their bits interleaved
+  std::array< std::pair< tk::real, tk::real >, 3 > box;
+  for (std::size_t d=0; d<3; ++d) {
+    auto mm = std::minmax_element( begin(coord[d]), end(coord[d]) );
+    box[d] = { *mm.first, *mm.second - *mm.first };
+  }
+  auto spread = []( std::uint64_t v ) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+  };
+  std::vector< std::uint64_t > key( m_nprobe, 0 );
+  for (std::size_t p=0; p<m_nprobe; ++p)
+    for (std::size_t d=0; d<3; ++d) {
+      auto q = box[d].second > 0.0 ?
+        (coord[d][p] - box[d].first) / box[d].second * 0x1fffff : 0.0;
+      key[p] |= spread( static_cast< std::uint64_t >( q ) ) << d;
+    }
+  std::vector< std::size_t > order( m_nprobe );
+  std::iota( begin(order), end(order), 0 );
+  std::stable_sort( begin(order), end(order),
+    [&]( std::size_t a, std::size_t b ){ return key[a] < key[b]; } );
+
+  // Create the probe array, a chare per PE, but at most a chare per point
+  auto nchare = std::min( m_nprobe, static_cast< std::size_t >( CkNumPes() ) );
+  m_nprobechare = static_cast< int >( nchare );
+  CkCallback created( CkReductionTarget(Driver,probesCreated), thisProxy );
+  CkCallback probed( CkReductionTarget(Driver,probed), thisProxy );
+  m_probes = CProxy_ProbeArray::ckNew();
+  for (std::size_t c=0; c<nchare; ++c) {
+    tk::UnsMesh::Coords chunk;
+    for (auto i = c * m_nprobe / nchare; i < (c+1) * m_nprobe / nchare; ++i)
+      for (std::size_t d=0; d<3; ++d)
+        chunk[d].push_back( coord[d][ order[i] ] );
+    m_probes[ static_cast< int >( c ) ].insert( chunk, created, probed );
+  }
+  m_probes.doneInserting();
+}
+
+void
+Driver::initCells()
+// *****************************************************************************
+// Read the source cells of mixed type and distribute them to a new CellArray
+//! \details The volume cells of all element blocks of the file given by
+//!   +m2m_cells, e.g., hexahedra, prisms, and pyramids, are read as they are,
+//!   without tetrahedralizing them. They are divided among a chare per PE in
+//!   the order given, each holding the nodes of its cells renumbered locally,
+//!   as the cells are only a source and need neither partitioning nor
+//!   communication maps.
+// *****************************************************************************
+{
+  tk::ExodusIIMeshReader er( g_cellfile );
+  std::vector< std::size_t > inpoel, cellptr;
+  er.readCells( inpoel, cellptr );
+  m_ncell = cellptr.size() - 1;
+  ErrChk( m_ncell > 0, "No volume cells in " + g_cellfile );
+
+  // Create the cell array, a chare per PE, but at most a chare per cell
+  auto nchare = std::min( m_ncell, static_cast< std::size_t >( CkNumPes() ) );
+  m_ncellchare = static_cast< int >( nchare );
+  CkCallback created( CkReductionTarget(Driver,cellsCreated), thisProxy );
+  m_cells = CProxy_CellArray::ckNew();
+  for (std::size_t c=0; c<nchare; ++c) {
+    // Renumber the nodes of the cells of the chare in the order visited
+    std::unordered_map< std::size_t, std::size_t > lid;
+    std::vector< std::size_t > gid, conn, ptr{ 0 };
+    for (auto e = c * m_ncell / nchare; e < (c+1) * m_ncell / nchare; ++e) {
+      for (auto j = cellptr[e]; j < cellptr[e+1]; ++j) {
+        auto l = lid.emplace( inpoel[j], gid.size() );
+        if (l.second) gid.push_back( inpoel[j] );
+        conn.push_back( l.first->second );
+      }
+      ptr.push_back( conn.size() );
+    }
+    m_cells[ static_cast< int >( c ) ].insert( er.readCoords( gid ), conn, ptr,
+                                               created );
+  }
+  m_cells.doneInserting();
+}
+
+void
+Driver::setLinear( int num_meshes, int source )
+// *****************************************************************************
+// Set the solution of all meshes before a transfer of the linear test
+//! \param[in] num_meshes Number of meshes
+//! \param[in] source Id of the source mesh of the transfer, negative for the
+//!   cells given by +m2m_cells
+//! \details The source is set to the linear solution, the dest meshes and
+//!   the probe points to NaN, so only the points that receive a value from
+//!   the transfer hold one, see checkFound(). All contribute to solutionSet.
+// *****************************************************************************
+{
+  LinearSolution s(5,7,8,2);
+  UnsetSolution n;
+  CkCallback cb( CkReductionTarget(Driver,solutionSet), thisProxy );
+  for (int i = 0; i < num_meshes; ++i) {
+    auto& m = m_meshes[ static_cast< std::size_t >( i ) ].m_mesharray;
+    if (i == source) m.setSolution( s, cb ); else m.setSolution( n, cb );
+  }
+  if (!g_probefile.empty()) m_probes.setSolution( n, cb );
+  if (source < 0) m_cells.setSolution( s, cb );
+}
+
+void
+Driver::checkFound( int meshid, int source, std::size_t npoint ) const
+// *****************************************************************************
+// Check the number of points of a mesh holding a value in the linear test
+//! \param[in] meshid Mesh id
+//! \param[in] source Id of the source mesh of the transfer, negative for the
+//!   cells given by +m2m_cells
+//! \param[in] npoint Number of points of the mesh holding a value, nodes, or
+//!   cell centroids with +m2m_cellfield, see MeshArray::checkSolution()
+//! \details All points of the source hold a value. So must all points of the
+//!   dest meshes of the transfers from the first mesh and from the cells with
+//!   +m2m_contained, i.e., if these contain all meshes, otherwise at least
+//!   one.
+// *****************************************************************************
+{
+  const auto& m = m_meshes[ static_cast< std::size_t >( meshid ) ];
+  auto total = g_cellfield >= 0 ? m.m_nelem : m.m_npoin;
+  CkPrintf( "ExaM2M> Mesh %i: %zu of %zu points hold the exact solution\n",
+            meshid, npoint, total );
+  if (meshid == source || (source <= 0 && g_contained))
+    ErrChk( npoint == total, "Not all points of mesh " +
+            std::to_string(meshid) + " received the linear solution" );
+  else
+    ErrChk( npoint > 0, "No point of mesh " + std::to_string(meshid) +
+            " received the linear solution" );
+}
+
 #include "NoWarning/driver.def.h"
@@ -54,6 +54,17 @@ class Driver : public CBase_Driver {
       p | m_meshes;
       p | m_timer;
       p | m_curriter;
+      p | m_ntransfer;
+      p | m_plan;
+      p | m_steptimes;
+      p | m_nstep;
+      p | m_varid;
+      p | m_probes;
+      p | m_nprobe;
+      p | m_nprobechare;
+      p | m_cells;
+      p | m_ncell;
+      p | m_ncellchare;
     }
     //! \brief Pack/Unpack serialize operator|
     //! \param[in,out] p Charm++'s PUP::er serializer object reference
@@ -70,6 +81,24 @@ class Driver : public CBase_Driver {
     //! number of elements and number of chares in the associated mesh
     void updatenelems( std::size_t meshid, std::size_t nelems );
 
+    //! Compute the key of the transfer plan between all meshes
+    CmiUInt8 planKey() const;
+
+    //! Find the time steps and the nodal field of the source to remap
+    void queryFields();
+
+    //! Read the probe points and distribute them to a new ProbeArray
+    void initProbes();
+
+    //! Read the source cells of mixed type and distribute them to a CellArray
+    void initCells();
+
+    //! Set the solution of all meshes before a transfer of the linear test
+    void setLinear( int num_meshes, int source );
+
+    //! Check the number of points of a mesh holding a value in the linear test
+    void checkFound( int meshid, int source, std::size_t npoint ) const;
+
     struct MeshData {
       int m_nchare;                        //!< Number of worker chares
       CProxy_Partitioner m_partitioner;    //!< Partitioner nodegroup proxy
@@ -78,6 +107,8 @@ class Driver : public CBase_Driver {
       CProxy_MeshArray m_mesharray;        //!< Mesh array proxy
       std::size_t m_nelem;                 //!< Total number of elements in mesh
       std::size_t m_npoin;                 //!< Total number of nodes in mesh
+      CmiUInt8 m_hash;                     //!< Content hash of mesh
+      std::string m_file;                  //!< Mesh file name
       void pup( PUP::er& p ) {
         p | m_nchare;
         p | m_partitioner;
@@ -86,6 +117,8 @@ class Driver : public CBase_Driver {
         p | m_mesharray;
         p | m_nelem;
         p | m_npoin;
+        p | m_hash;
+        p | m_file;
       }
       friend void operator|( PUP::er& p, MeshData& t ) { t.pup(p); }
     };
@@ -96,6 +129,28 @@ class Driver : public CBase_Driver {
     std::vector< tk::Timer > m_timer;
     //! SDAG variable for iteration
     int m_curriter;
+    //! Number of transfers reported, tagging the reports across all tests
+    int m_ntransfer;
+    //! True if a transfer plan is available, so transfers only apply weights
+    bool m_plan;
+    //! Times of the time steps of the source results file to remap
+    std::vector< tk::real > m_steptimes;
+    //! Number of time steps to remap
+    int m_nstep;
+    //! Id of the nodal variable of the source results file to remap
+    int m_varid;
+    //! Probe array proxy, if probe points are given
+    CProxy_ProbeArray m_probes;
+    //! Total number of probe points
+    std::size_t m_nprobe;
+    //! Number of probe array chares
+    int m_nprobechare;
+    //! Cell array proxy, if source cells of mixed type are given
+    CProxy_CellArray m_cells;
+    //! Total number of source cells of mixed type
+    std::size_t m_ncell;
+    //! Number of cell array chares
+    int m_ncellchare;
 };
 
 } // exam2m::
@@ -12,6 +12,9 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <string>
+#include <vector>
+#include <sstream>
 
 #include "ProcessException.hpp"
 
@@ -52,6 +55,24 @@ tk::real g_virtualization = 0.0;
 
 int g_totaliter = 1;
 int g_mode = 0;
+bool g_loadbalance = false;
+bool g_reuseweights = false;
+std::string g_planprefix;
+bool g_nodeoutput = false;
+bool g_asyncoutput = false;
+std::string g_fieldname;
+bool g_surface = false;
+tk::real g_surfacetol = 0.0;
+std::vector< tk::real > g_region;
+std::vector< int > g_regionsets;
+std::string g_probefile;
+tk::real g_chareoverhead = 4096.0;
+int g_cellfield = -1;
+bool g_contained = false;
+std::string g_cellfile;
+std::string g_timingsfile;
+std::string g_diagfile;
+int g_diagtopn = 10;
 
 #if defined(__clang__)
   #pragma clang diagnostic pop
@@ -59,6 +80,30 @@ int g_mode = 0;
 
 } // exam2m::
 
+namespace {
+
+//! Parse a comma-separated list of numbers given as a command line argument
+//! \tparam T Type of numbers to parse
+//! \param[in] flag Command line flag the argument belongs to (for errors)
+//! \param[in] arg Command line argument to parse
+//! \return Numbers parsed
+template< class T >
+std::vector< T > parseList( const std::string& flag, const std::string& arg )
+{
+  std::vector< T > v;
+  std::stringstream ss( arg );
+  std::string s;
+  while (std::getline( ss, s, ',' )) {
+    T x;
+    ErrChk( static_cast< bool >( std::stringstream( s ) >> x ),
+            flag + " requires comma-separated numbers, got: " + arg );
+    v.push_back( x );
+  }
+  return v;
+}
+
+} // ::
+
 //! Charm++ main chare for the exam2m executable.
 class Main : public CBase_Main {
 
@@ -69,17 +114,136 @@ class Main : public CBase_Main {
       // Create driver
       m_signal( tk::setSignalHandlers() )
     {
+      // Parse optional flags, removing them from the arguments
+      exam2m::g_loadbalance = CmiGetArgFlagDesc( msg->argv, "+m2m_balance",
+        "Balance the load measured during transfers between iterations" );
+      exam2m::g_reuseweights = CmiGetArgFlagDesc( msg->argv, "+m2m_weights",
+        "Collect interpolation weights in the first transfer and only apply "
+        "them to the source solution in later iterations" );
+      char* plan = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_plan", &plan,
+            "Load the transfer plan from files with the given prefix, or "
+            "save it there after the first transfer if not found" ))
+        exam2m::g_planprefix = plan;
+      exam2m::g_nodeoutput = CmiGetArgFlagDesc( msg->argv, "+m2m_nodeoutput",
+        "Write a single output file per compute node, containing the mesh "
+        "chunks of all of its chares, instead of a file per chare" );
+      exam2m::g_asyncoutput = CmiGetArgFlagDesc( msg->argv, "+m2m_asyncoutput",
+        "Write output files on a background thread, overlapping output with "
+        "the transfers that follow it" );
+      char* field = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_field", &field,
+            "Name of the nodal variable of the source results file to remap "
+            "in mode 4, default: the first one" ))
+        exam2m::g_fieldname = field;
+      exam2m::g_surface = CmiGetArgDoubleDesc( msg->argv, "+m2m_surface",
+        &exam2m::g_surfacetol, "Transfer between the side sets of the meshes "
+        "instead of their volumes, accepting dest nodes up to the given "
+        "distance from the source surface" );
+      char* region = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_region", &region,
+            "Only transfer into the dest nodes inside the box "
+            "xmin,ymin,zmin,xmax,ymax,zmax, from the source cells overlapping "
+            "it" )) {
+        exam2m::g_region = parseList< tk::real >( "+m2m_region", region );
+        ErrChk( exam2m::g_region.size() == 6, "+m2m_region requires 6 "
+                "comma-separated values" );
+        for (std::size_t j=0; j<3; ++j)
+          ErrChk( exam2m::g_region[j] <= exam2m::g_region[j+3],
+                  "+m2m_region minimum larger than maximum" );
+      }
+      char* sets = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_regionsets", &sets,
+            "Only transfer into the dest nodes of the given comma-separated "
+            "side set ids, from the source side sets with these ids in a "
+            "surface transfer" ))
+        exam2m::g_regionsets = parseList< int >( "+m2m_regionsets", sets );
+      char* probes = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_probes", &probes,
+            "Also sample the solution transferred at the probe points given "
+            "in the file, x y z per line" ))
+        exam2m::g_probefile = probes;
+      CmiGetArgDoubleDesc( msg->argv, "+m2m_chareoverhead",
+        &exam2m::g_chareoverhead, "Cost of a mesh chare in units of the cost "
+        "of a mesh cell, used with automatic virtualization" );
+      CmiGetArgIntDesc( msg->argv, "+m2m_cellfield", &exam2m::g_cellfield,
+        "Transfer a cell-centered field from the source cells into the dest "
+        "cell centroids, constant (0) or linear (1) in each cell, instead of "
+        "the nodal field" );
+      exam2m::g_contained = CmiGetArgFlagDesc( msg->argv, "+m2m_contained",
+        "The first mesh, and the cells given by +m2m_cells, contain all "
+        "meshes, so the linear test (modes 2 and 3) requires all of their "
+        "points to receive a value from these" );
+      char* cells = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_cells", &cells,
+            "Also transfer the linear test solution from the volume cells of "
+            "mixed type, e.g., hexahedra, prisms, and pyramids, of this "
+            "ExodusII file into all meshes" ))
+        exam2m::g_cellfile = cells;
+      char* timings = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_timings", &timings,
+            "Report the time spent in each transfer phase after each "
+            "transfer, appending it to the given CSV file" ))
+        exam2m::g_timingsfile = timings;
+      char* diag = nullptr;
+      if (CmiGetArgStringDesc( msg->argv, "+m2m_diagnostics", &diag,
+            "Report the transfer diagnostics counters after each transfer, "
+            "appending the counters of each chare to the given CSV file" ))
+        exam2m::g_diagfile = diag;
+      CmiGetArgIntDesc( msg->argv, "+m2m_diagtopn", &exam2m::g_diagtopn,
+        "Number of hottest source chares listed by +m2m_diagnostics, "
+        "default: 10" );
+      msg->argc = CmiGetArgc( msg->argv );
+      ErrChk( exam2m::g_probefile.empty() || exam2m::g_planprefix.empty(),
+              "+m2m_probes cannot be combined with +m2m_plan" );
+      ErrChk( exam2m::g_chareoverhead > 0.0,
+              "+m2m_chareoverhead requires a positive number" );
+      ErrChk( exam2m::g_diagtopn >= 0,
+              "+m2m_diagtopn requires a non-negative number" );
+
       CkPrintf("ExaM2M> Args:");
       for (int i = 1; i < msg->argc; i++) CkPrintf("%s ", msg->argv[i]);
       CkPrintf("\n");
 
       if (msg->argc < 6) {
-        Throw( "Args require an iteration, virtualization, and at least two meshes" );
+        Throw( "Args require an iteration, virtualization (or 'auto'), and at least two meshes" );
       }
 
       exam2m::g_mode = std::atoi( msg->argv[1] );
       exam2m::g_totaliter = std::atoi( msg->argv[2] );
-      exam2m::g_virtualization = std::atof( msg->argv[3] );
+      // Negative virtualization selects the number of chares automatically
+      if (std::string( msg->argv[3] ) == "auto") {
+        exam2m::g_virtualization = -1.0;
+      } else {
+        std::stringstream ss( msg->argv[3] );
+        ErrChk( static_cast< bool >( ss >> exam2m::g_virtualization ) &&
+                exam2m::g_virtualization >= 0.0 &&
+                exam2m::g_virtualization <= 1.0,
+                "Virtualization must be 'auto' or between 0.0 and 1.0, got: " +
+                std::string( msg->argv[3] ) );
+      }
+
+      if (exam2m::g_cellfield >= 0) {
+        ErrChk( exam2m::g_cellfield <= 1, "+m2m_cellfield requires 0 or 1" );
+        ErrChk( !exam2m::g_surface && exam2m::g_region.empty() &&
+                exam2m::g_regionsets.empty(), "+m2m_cellfield cannot be "
+                "combined with +m2m_surface, +m2m_region, or +m2m_regionsets" );
+        ErrChk( exam2m::g_mode != 4, "+m2m_cellfield cannot remap in mode 4" );
+        ErrChk( exam2m::g_cellfield == 0 || (!exam2m::g_reuseweights &&
+                exam2m::g_planprefix.empty()), "+m2m_cellfield 1 cannot be "
+                "combined with +m2m_weights or +m2m_plan" );
+        ErrChk( exam2m::g_cellfield == 1 || exam2m::g_mode < 2,
+                "+m2m_cellfield 0 is not exact for the linear test of modes "
+                "2 and 3" );
+      }
+      ErrChk( !exam2m::g_contained || (!exam2m::g_surface &&
+              exam2m::g_region.empty() && exam2m::g_regionsets.empty()),
+              "+m2m_contained cannot be combined with +m2m_surface, "
+              "+m2m_region, or +m2m_regionsets, which transfer into part of "
+              "the points only" );
+      ErrChk( exam2m::g_cellfile.empty() ||
+              exam2m::g_mode == 2 || exam2m::g_mode == 3,
+              "+m2m_cells requires the linear test of modes 2 and 3" );
 
       mainProxy = thisProxy;
 
@@ -88,10 +88,10 @@ Mapper::setup( std::size_t npoin )
   // communication maps across all chares. The binning is determined by the
   // global node id divided by the chunksizes.
   tk::CommMaps chbnd;
-  auto el = tk::global2local( m_ginpoel );      // generate local mesh data
-  const auto& inpoel = std::get< 0 >( el );     // local connectivity
-  auto esup = tk::genEsup( inpoel, 4 );         // elements surrounding points
-  auto esuel = tk::genEsuelTet( inpoel, esup ); // elems surrounding elements
+  auto el = tk::global2local( m_ginpoel );         // generate local mesh data
+  const auto& inpoel = std::get< 0 >( el );        // local connectivity
+  auto esup = tk::genEsupPar( inpoel, 4 );         // elems surrounding points
+  auto esuel = tk::genEsuelTetPar( inpoel, esup ); // elems surrounding elems
   for (std::size_t e=0; e<esuel.size()/4; ++e) {
     auto mark = e*4;
     for (std::size_t f=0; f<4; ++f)
@@ -9,10 +9,22 @@
 // *****************************************************************************
 
 #include <iostream>     // NOT NEEDED WHEN DEBUGGED
+#include <map>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include <memory>
+#include <numeric>
+#include <algorithm>
 
 #include "MeshArray.hpp"
 #include "Reorder.hpp"
 #include "DerivedData.hpp"
+#include "ContainerUtil.hpp"
+#include "Exception.hpp"
+#include "ExodusIIMeshReader.hpp"
+#include "IOThread.hpp"
+#include "Vector.hpp"
 
 #include "Controller.hpp"
 
@@ -25,8 +37,38 @@ PUPbytes(Collision);
   #pragma clang diagnostic pop
 #endif
 
+namespace exam2m {
+
+extern int g_mode;
+extern bool g_reuseweights;
+extern std::string g_planprefix;
+extern bool g_nodeoutput;
+extern bool g_surface;
+extern tk::real g_surfacetol;
+extern std::vector< tk::real > g_region;
+extern std::vector< int > g_regionsets;
+extern int g_cellfield;
+
+}
+
 using exam2m::MeshArray;
 
+namespace {
+
+//! Access the reader of a results file, opening it on first use
+//! \param[in] file Results file name
+//! \return Reader of the results file, kept open for all time steps read
+//! \note Only called on the background I/O thread, which serializes access
+tk::ExodusIIMeshReader& fieldReader( const std::string& file ) {
+  static std::map< std::string, std::unique_ptr< tk::ExodusIIMeshReader > >
+    readers;
+  auto& r = readers[ file ];
+  if (!r) r = std::make_unique< tk::ExodusIIMeshReader >( file );
+  return *r;
+}
+
+} // ::
+
 MeshArray::MeshArray(
   const tk::CProxy_MeshWriter& meshwriter,
   const tk::MeshCallback& cbw,
@@ -45,13 +87,14 @@ MeshArray::MeshArray(
   m_t( 0.0 ),
   m_lastDumpTime( -std::numeric_limits< tk::real >::max() ),  
   m_meshwriter( meshwriter ),
-  m_el( tk::global2local( ginpoel ) ),     // fills m_inpoel, m_gid, m_lid
+  m_el( tk::global2local( ginpoel ) ),     // fills m_gid, m_lid
   m_coord( setCoord( coordmap ) ),
   m_nodeCommMap(),
   m_bface( bface ),
   m_triinpoel( triinpoel ),
   m_bnode( bnode ),
-  m_u( m_coord[0].size(), 1 )
+  m_u( m_coord[0].size(), 1 ),
+  m_readticket( 0 )
 // *****************************************************************************
 //  Constructor
 //! \param[in] meshwriter Mesh writer proxy
@@ -67,11 +110,48 @@ MeshArray::MeshArray(
 // *****************************************************************************
 {
   Assert( !ginpoel.empty(), "No elements assigned to MeshArray chare" );
-  Assert( tk::positiveJacobians( m_inpoel, m_coord ),
+
+  // Enable load balancing using the load measured by the transfer library
+  usesAtSync = true;
+  usesAutoMeasure = false;
+
+  auto& inpoel = std::get< 0 >( m_el );
+
+  // Reorder nodes and elements of our mesh chunk for cache locality
+  tk::reorder( inpoel, m_gid, m_lid, m_coord );
+
+  Assert( tk::positiveJacobians( inpoel, m_coord ),
           "Jacobian in input mesh to MeshArray non-positive" );
-  Assert( tk::conforming( m_inpoel, m_coord ),
+  Assert( tk::conforming( inpoel, m_coord ),
           "Input mesh to MeshArray not conforming" );
 
+  // Store element connectivity using the local index type
+  ErrChk( m_gid.size() <= std::numeric_limits< tk::lindex >::max(),
+          "Mesh chunk too large for the local index type, reconfigure with "
+          "-DLOCAL_INDEX=64 or use more chares" );
+  m_inpoel.assign( begin(inpoel), end(inpoel) );
+  tk::destroy( inpoel );
+
+  // Store cell centroids if cell-centered fields are transferred
+  if (g_cellfield >= 0) {
+    const auto ne = m_inpoel.size()/4;
+    for (std::size_t j=0; j<3; ++j) {
+      const auto& c = m_coord[j];
+      m_centroid[j].resize( ne );
+      for (std::size_t e=0; e<ne; ++e)
+        m_centroid[j][e] = (c[m_inpoel[e*4+0]] + c[m_inpoel[e*4+1]] +
+                            c[m_inpoel[e*4+2]] + c[m_inpoel[e*4+3]]) / 4.0;
+    }
+    m_ue = tk::Fields( ne, 4 );
+  }
+
+  // Store side set triangles with local IDs for surface transfers
+  for (auto g : m_triinpoel)
+    m_surftri.push_back( static_cast< tk::lindex >( tk::cref_find(m_lid,g) ) );
+
+  // Select the parts of the mesh chunk taking part in transfers
+  selectRegion();
+
   // Store communication maps
   for (const auto& [ c, maps ] : commaps) {
     m_nodeCommMap[c] = maps.get< tag::node >();
@@ -87,20 +167,66 @@ MeshArray::setSolution(Solution& s, CkCallback cb) {
   for (std::size_t i = 0; i < m_coord[0].size(); i++) {
     m_u(i,0,0) = s.f(m_coord[0][i], m_coord[1][i], m_coord[2][i]);
   }
+  // Cell values at the centroids with the gradients of the linear
+  // interpolant of the nodal values, as a finite volume code would hold them
+  const auto& x = m_coord[0];
+  const auto& y = m_coord[1];
+  const auto& z = m_coord[2];
+  for (std::size_t e = 0; e < m_ue.nunk(); e++) {
+    const auto N = m_inpoel.data() + e*4;
+    std::array< std::array< tk::real, 3 >, 3 > J;
+    std::array< tk::real, 3 > df;
+    auto fA = m_u(N[0],0,0);
+    for (std::size_t i=0; i<3; ++i) {
+      for (std::size_t j=0; j<3; ++j)
+        J[i][j] = m_coord[j][N[i+1]] - m_coord[j][N[0]];
+      df[i] = m_u(N[i+1],0,0) - fA;
+    }
+    auto g = tk::cramer( J, df );
+    m_ue(e,0,0) = s.f(m_centroid[0][e], m_centroid[1][e], m_centroid[2][e]);
+    for (std::size_t j=0; j<3; ++j) m_ue(e,j+1,0) = g[j];
+  }
   contribute(cb);
 }
 
-void MeshArray::checkSolution(Solution& s, CkCallback cb) {
-  for (std::size_t i = 0; i < m_coord[0].size(); i++) {
-    tk::real expected = s.f(m_coord[0][i], m_coord[1][i], m_coord[2][i]);
-    tk::real diff = abs(m_u(i,0,0) - expected);
-    if (diff > std::numeric_limits<float>::epsilon() && m_u(i,0,0) > diff) {
-      CkAbort("Elem %i/%i (%f %f %f) DIFF TOO BIG! %f - %f = %e\n",
-          i, m_coord[0].size(), m_coord[0][i], m_coord[1][i], m_coord[2][i],
-          expected, m_u(i,0,0), diff);
+void
+MeshArray::checkSolution(Solution& s, CkCallback cb)
+// *****************************************************************************
+//  Check the solution transferred against the exact solution
+//! \param[in] s Exact solution
+//! \param[in] cb Callback to contribute the number of points holding a value to
+//! \details Points that received no value hold NaN, see UnsetSolution, and
+//!   are only skipped. All others must match the exact solution up to
+//!   roundoff. Nodes shared with lower chares are counted by those, so the
+//!   points of the whole mesh are counted once. With +m2m_cellfield the cell
+//!   centroids, which the cell field is transferred into, are checked instead
+//!   of the nodes.
+// *****************************************************************************
+{
+  const bool cells = g_cellfield >= 0;
+  const auto& c = cells ? m_centroid : m_coord;
+  const auto& u = cells ? m_ue : m_u;
+
+  std::unordered_set< std::size_t > shared;
+  if (!cells)
+    for (const auto& [ chare, nodes ] : m_nodeCommMap)
+      if (chare < thisIndex) shared.insert( begin(nodes), end(nodes) );
+
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < c[0].size(); i++) {
+    if (std::isnan( u(i,0,0) )) continue;
+    if (!cells && shared.count( m_gid[i] )) continue;
+    ++n;
+    tk::real expected = s.f(c[0][i], c[1][i], c[2][i]);
+    tk::real diff = std::abs(u(i,0,0) - expected);
+    if (diff > std::numeric_limits<float>::epsilon() *
+               std::max( 1.0, std::abs(expected) )) {
+      CkAbort("%s %zu/%zu (%f %f %f) DIFF TOO BIG! %f - %f = %e\n",
+          cells ? "Cell" : "Node", i, c[0].size(), c[0][i], c[1][i], c[2][i],
+          expected, u(i,0,0), diff);
     }
   }
-  contribute(cb);
+  contribute( sizeof(std::size_t), &n, CkReduction::sum_ulong, cb );
 }
 
 void
@@ -124,6 +250,12 @@ MeshArray::out( int meshid )
   nodefieldnames.push_back( "scalar" );
   nodefields.push_back( m_u.extract(0, 0) );
 
+  // Cell-centered field transferred instead of the nodal one
+  if (g_cellfield >= 0) {
+    elemfieldnames.push_back( "scalar" );
+    elemfields.push_back( m_ue.extract(0, 0) );
+  }
+
   // Surface field data in nodes
   std::vector< std::string > nodesurfnames;
   std::vector< std::vector< tk::real > > nodesurfs;
@@ -134,12 +266,64 @@ MeshArray::out( int meshid )
   // debugging.
 
   // Send mesh and fields data for output to file
-  write( meshid, m_inpoel, m_coord, m_bface, tk::remap( m_bnode, m_lid ),
+  write( meshid, std::vector< std::size_t >( begin(m_inpoel), end(m_inpoel) ),
+         m_coord, m_bface, tk::remap( m_bnode, m_lid ),
          m_triinpoel, elemfieldnames, nodefieldnames, nodesurfnames,
          elemfields, nodefields, nodesurfs,
          CkCallback(CkIndex_MeshArray::written(), thisProxy[thisIndex]) );
 }
 
+void
+MeshArray::outStep( int meshid, tk::real t )
+// *****************************************************************************
+// Write out field data of a time step to file(s)
+//! \param[in] meshid Mesh id
+//! \param[in] t Physical time of the time step
+// *****************************************************************************
+{
+  m_t = t;
+  out( meshid );
+}
+
+void
+MeshArray::nextStep( const std::string& file,
+                     int varid,
+                     int step,
+                     CkCallback c )
+// *****************************************************************************
+// Swap in the time step read last and start reading the next one
+//! \param[in] file Results file to read the time step from
+//! \param[in] varid Id (1-based) of the nodal variable to read
+//! \param[in] step Time step (0-based) to start reading, negative if none
+//! \param[in] c Callback to contribute to once the time step read last is in
+//!   m_u and the next one is being read
+//! \details The time step is read on the background I/O thread, which also
+//!   serializes the reads with asynchronous output, since ExodusII is not
+//!   thread-safe, so reading the next time step overlaps with transferring
+//!   the current one. Each chare reads the values at its own nodes. Only
+//!   waiting for a read still in progress blocks this PE.
+// *****************************************************************************
+{
+  auto& io = tk::IOThread::instance();
+
+  if (m_readticket) {
+    io.wait( m_readticket );
+    m_readticket = 0;
+    Assert( m_next.size() == m_u.nunk(), "Size mismatch" );
+    for (std::size_t i=0; i<m_next.size(); ++i) m_u(i,0,0) = m_next[i];
+  }
+
+  if (step >= 0) {
+    m_readticket = io.post(
+      [ file, varid, step, gid = m_gid, next = &m_next ](){
+        *next = fieldReader( file ).readNodeScalar(
+                  static_cast< uint64_t >( step ), varid, gid );
+      } );
+  }
+
+  contribute( c );
+}
+
 void
 MeshArray::written()
 // *****************************************************************************
@@ -173,6 +357,79 @@ MeshArray::setCoord( const tk::UnsMesh::CoordMap& coordmap )
   return coord;
 }
 
+void
+MeshArray::selectRegion()
+// *****************************************************************************
+// Select the source elements and dest nodes of the region of interest
+//! \details A surface transfer (+m2m_surface) transfers into the side set
+//!   nodes only. The region of interest restricts this further, to the nodes
+//!   of the side sets given by +m2m_regionsets, and to the nodes inside the
+//!   box given by +m2m_region. The source elements are restricted to those
+//!   whose bounding box overlaps the box, grown by the surface tolerance in a
+//!   surface transfer, and to the triangles of the side sets given, if the
+//!   source is a surface.
+// *****************************************************************************
+{
+  auto lid = [&]( std::size_t g )
+    { return static_cast< tk::lindex >( tk::cref_find(m_lid,g) ); };
+
+  // Return true if the bounding box of nodes overlaps the region of interest
+  auto inbox = [&]( const tk::lindex* n, std::size_t nn, tk::real d ){
+    if (g_region.empty()) return true;
+    for (std::size_t j=0; j<3; ++j) {
+      const auto& c = m_coord[j];
+      auto [ lo, hi ] = std::minmax_element( n, n+nn,
+        [&]( tk::lindex a, tk::lindex b ){ return c[a] < c[b]; } );
+      if (c[*hi] + d < g_region[j] || c[*lo] - d > g_region[j+3]) return false;
+    }
+    return true;
+  };
+
+  // Dest nodes
+  m_destnode.clear();
+  if (!g_regionsets.empty()) {
+    for (auto s : g_regionsets) {
+      auto b = m_bnode.find( s );
+      if (b != end(m_bnode))
+        for (auto g : b->second) m_destnode.push_back( lid(g) );
+    }
+  } else if (g_surface) {
+    for (const auto& [ setid, nodes ] : m_bnode)
+      for (auto g : nodes) m_destnode.push_back( lid(g) );
+  } else if (!g_region.empty()) {
+    m_destnode.resize( m_coord[0].size() );
+    std::iota( begin(m_destnode), end(m_destnode), 0 );
+  }
+  tk::unique( m_destnode );
+  m_destnode.erase( std::remove_if( begin(m_destnode), end(m_destnode),
+    [&]( tk::lindex p ){ return !inbox( &p, 1, 0.0 ); } ), end(m_destnode) );
+
+  // Source elements
+  m_srcelem.clear();
+  if (g_surface && (!g_region.empty() || !g_regionsets.empty())) {
+    if (!g_regionsets.empty()) {
+      for (auto s : g_regionsets) {
+        auto b = m_bface.find( s );
+        if (b != end(m_bface))
+          for (auto f : b->second)
+            m_srcelem.push_back( static_cast< tk::lindex >( f ) );
+      }
+      tk::unique( m_srcelem );
+    } else {
+      m_srcelem.resize( m_surftri.size()/3 );
+      std::iota( begin(m_srcelem), end(m_srcelem), 0 );
+    }
+    m_srcelem.erase( std::remove_if( begin(m_srcelem), end(m_srcelem),
+      [&]( tk::lindex e ){ return !inbox( m_surftri.data()+e*3, 3,
+                                          g_surfacetol ); } ),
+      end(m_srcelem) );
+  } else if (!g_region.empty()) {
+    for (std::size_t e=0; e<m_inpoel.size()/4; ++e)
+      if (inbox( m_inpoel.data()+e*4, 4, 0.0 ))
+        m_srcelem.push_back( static_cast< tk::lindex >( e ) );
+  }
+}
+
 void
 MeshArray::write(
   int meshid,
@@ -218,7 +475,10 @@ MeshArray::write(
 //!   output is serialized through the first PE of each compute node. In SMP
 //!   mode, channeling multiple files via a single PE on each node is required
 //!   by NetCDF and HDF5, as well as ExodusII, since none of these libraries are
-//!   thread-safe.
+//!   thread-safe. With aggregated output (+m2m_nodeoutput) the chunks of all
+//!   chares of a compute node are written into a single file, for which the
+//!   chares also pass their global node ids and count themselves per compute
+//!   node, so the writer knows how many chunks to wait for.
 // *****************************************************************************
 {
   // If the previous iteration refined (or moved) the mesh or this is called
@@ -235,10 +495,18 @@ MeshArray::write(
     fieldoutput = true;
   }
 
+  if (g_nodeoutput) {
+    std::vector< int > count( static_cast< std::size_t >( CkNumNodes() ), 0 );
+    count[ static_cast< std::size_t >( CkMyNode() ) ] = 1;
+    contribute( count, CkReduction::sum_int,
+      CkCallback( CkReductionTarget(tk::MeshWriter,nodechares),
+                  m_meshwriter ) );
+  }
+
   m_meshwriter[ CkNodeFirst( CkMyNode() ) ].
     write( meshoutput, fieldoutput, m_itr, m_itf, m_t, thisIndex,
            "out." + std::to_string(meshid),       // output basefilename
-           inpoel, coord, bface, bnode, triinpoel, elemfieldnames,
+           inpoel, coord, m_gid, bface, bnode, triinpoel, elemfieldnames,
            nodefieldnames, nodesurfnames, elemfields, nodefields, nodesurfs,
            {},  // no surface output for now (even if passed in nodesurf)
            c );
@@ -247,17 +515,144 @@ MeshArray::write(
 void MeshArray::transferSource()
 // *****************************************************************************
 //  Pass Mesh Data to m2m transfer library
+//! \details With +m2m_surface only the side set triangles are the source.
+//!   The source may be restricted to a region of interest, see selectRegion().
+//!   With +m2m_cellfield the cell field is the source instead of the nodal
+//!   one, constant or linear in each cell.
 // *****************************************************************************
 {
-  exam2m::setSourceTets(thisProxy, thisIndex, &m_inpoel, &m_coord, m_u);
+  if (g_cellfield >= 0)
+    exam2m::setSourceTets(thisProxy, thisIndex, &m_inpoel, &m_coord, m_ue,
+      nullptr, g_cellfield == 0 ? exam2m::SourceField::CELL
+                                : exam2m::SourceField::CELL_LINEAR);
+  else if (g_surface)
+    exam2m::setSourceTris(thisProxy, thisIndex, &m_surftri, &m_coord, m_u,
+      g_surfacetol, !g_region.empty() || !g_regionsets.empty() ?
+                    &m_srcelem : nullptr);
+  else
+    exam2m::setSourceTets(thisProxy, thisIndex, &m_inpoel, &m_coord, m_u,
+      !g_region.empty() ? &m_srcelem : nullptr);
 }
 
 void MeshArray::transferDest()
 // *****************************************************************************
 //  Pass Mesh Data to m2m transfer library
+//! \details The transfer is split-phase: the solution data is staged by the
+//!   library and only applied to m_u once transferArrived() waits for it, so
+//!   m_u may be worked on while the transfer is in progress. Interpolation
+//!   weights are collected if they are reused by later iterations or saved
+//!   as a transfer plan. With +m2m_surface only the side set nodes are
+//!   transferred into, and the nodes may be restricted to a region of
+//!   interest, see selectRegion(). With +m2m_cellfield the cell centroids are
+//!   transferred into, receiving the values of the cell field.
+// *****************************************************************************
+{
+  if (g_cellfield >= 0) {
+    m_transfer = exam2m::startTransfer(thisProxy, thisIndex, &m_centroid, m_ue,
+      CkCallback(CkIndex_MeshArray::transferArrived(), thisProxy[thisIndex]),
+      g_reuseweights || !g_planprefix.empty());
+    return;
+  }
+  m_transfer = exam2m::startTransfer(thisProxy, thisIndex, &m_coord, m_u,
+    CkCallback(CkIndex_MeshArray::transferArrived(), thisProxy[thisIndex]),
+    g_reuseweights || !g_planprefix.empty() || g_mode == 4,
+    g_surface || !g_region.empty() || !g_regionsets.empty() ?
+      &m_destnode : nullptr);
+}
+
+void MeshArray::transferArrived()
+// *****************************************************************************
+//  All solution data of the transfer arrived, apply it to m_u
+// *****************************************************************************
+{
+  exam2m::waitTransfer(m_transfer,
+    CkCallback(CkIndex_MeshArray::solutionFound(), thisProxy[thisIndex]));
+}
+
+void MeshArray::applySource()
+// *****************************************************************************
+//  Send source values to apply the interpolation weights of the last transfer
+// *****************************************************************************
+{
+  exam2m::applySource(thisProxy, thisIndex, g_cellfield >= 0 ? m_ue : m_u);
+}
+
+void MeshArray::applyDest()
+// *****************************************************************************
+//  Apply the interpolation weights of the last transfer to the source values
+//  received, instead of transferring the solution again
+// *****************************************************************************
+{
+  exam2m::applyDest(thisProxy, thisIndex, g_cellfield >= 0 ? m_ue : m_u,
+    CkCallback(CkIndex_MeshArray::solutionFound(), thisProxy[thisIndex]));
+}
+
+void MeshArray::hashMesh( CkCallback cb )
+// *****************************************************************************
+//  Contribute the content hash of our mesh chunk to a reduction
+//! \param[in] cb Callback to send the content hash of the whole mesh to
+// *****************************************************************************
+{
+  exam2m::hashMesh(thisProxy, thisIndex, m_inpoel, m_coord, cb);
+}
+
+void MeshArray::savePlan( const std::string& prefix, CmiUInt8 key,
+                          CkCallback cb )
+// *****************************************************************************
+//  Save the transfer plan of the last transfer to file
+//! \param[in] prefix File name prefix of the transfer plan
+//! \param[in] key Transfer plan key, see exam2m::planKey()
+//! \param[in] cb Callback to contribute to once saved
+// *****************************************************************************
+{
+  exam2m::savePlan(thisProxy, thisIndex, prefix, key);
+  contribute(cb);
+}
+
+void MeshArray::loadPlan( const std::string& prefix, CmiUInt8 key,
+                          CkCallback cb )
+// *****************************************************************************
+//  Load the transfer plan from file
+//! \param[in] prefix File name prefix of the transfer plan
+//! \param[in] key Transfer plan key, see exam2m::planKey()
+//! \param[in] cb Callback to contribute to, true if all chares loaded a plan
+// *****************************************************************************
+{
+  // Points transferred into, see transferDest()
+  auto npoin = g_cellfield >= 0 ? m_centroid[0].size() : m_coord[0].size();
+  bool ok = exam2m::loadPlan(thisProxy, thisIndex, prefix, key, npoin);
+  contribute(sizeof(bool), &ok, CkReduction::logical_and_bool, cb);
+}
+
+void MeshArray::balance( CkCallback cb )
+// *****************************************************************************
+//  Migrate to balance the load measured during transfers
+//! \param[in] cb Callback to contribute to after load balancing
+//! \details Must only be called between transfers.
+// *****************************************************************************
+{
+  m_balancecb = cb;
+  AtSync();
+}
+
+void MeshArray::UserSetLBLoad()
+// *****************************************************************************
+//  Set the load measured during transfers for the load balancer
+//! \details The load is the time the bound transfer library worker spent
+//!   since the last load balancing step checking candidate points against
+//!   our tetrahedra, where most of the transfer time goes, and receiving and
+//!   applying the solution transferred into our nodes.
+// *****************************************************************************
+{
+  setObjTime( exam2m::transferLoad( thisProxy, thisIndex ) );
+}
+
+void MeshArray::ResumeFromSync()
+// *****************************************************************************
+//  Resume after load balancing
 // *****************************************************************************
 {
-  exam2m::setDestPoints(thisProxy, thisIndex, &m_coord, m_u, CkCallback(CkIndex_MeshArray::solutionFound(), thisProxy[thisIndex]));
+  contribute( m_balancecb );
 }
 
 void MeshArray::solutionFound() {
@@ -10,11 +10,14 @@
 #ifndef MeshArray_h
 #define MeshArray_h
 
+#include <limits>
+
 #include "Types.hpp"
 #include "PUPUtil.hpp"
 #include "UnsMesh.hpp"
 #include "CommMap.hpp"
 #include "Fields.hpp"
+#include "Controller.hpp"
 
 namespace exam2m {
 
@@ -46,6 +49,17 @@ public:
   }
 };
 
+//! Solution of points that have not received a value, see checkSolution()
+class UnsetSolution : public Solution {
+PUPable_decl(UnsetSolution);
+public:
+  UnsetSolution() {}
+  UnsetSolution(CkMigrateMessage* m) {}
+  tk::real f(tk::real x, tk::real y, tk::real z) const {
+    return std::numeric_limits< tk::real >::quiet_NaN();
+  }
+};
+
 class ExampleSolution : public Solution {
 PUPable_decl(ExampleSolution);
 public:
@@ -100,7 +114,10 @@ class MeshArray : public CBase_MeshArray {
     #endif
     //! Migrate constructor
     // cppcheck-suppress uninitMemberVar
-    explicit MeshArray( CkMigrateMessage* ) {}
+    explicit MeshArray( CkMigrateMessage* ) : m_readticket( 0 ) {
+      usesAtSync = true;
+      usesAutoMeasure = false;
+    }
     #if defined(__clang__)
       #pragma clang diagnostic pop
     #endif
@@ -126,11 +143,43 @@ class MeshArray : public CBase_MeshArray {
     //! Mesh and field data written to file(s)
     void written();
 
+    //! Write out field data of a time step to file(s)
+    void outStep( int meshid, tk::real t );
+
+    //! Swap in the time step read last and start reading the next one
+    void nextStep( const std::string& file, int varid, int step,
+                   CkCallback c );
+
     void setSolution(Solution& s, CkCallback cb);
     void checkSolution(Solution& s, CkCallback cb);
     void solutionFound();
     void transferSource();
     void transferDest();
+    void transferArrived();
+
+    //! Send source values to apply the weights of the last transfer
+    void applySource();
+
+    //! Apply the weights of the last transfer to the source values received
+    void applyDest();
+
+    //! Contribute the content hash of our mesh chunk to a reduction
+    void hashMesh( CkCallback cb );
+
+    //! Save the transfer plan of the last transfer to file
+    void savePlan( const std::string& prefix, CmiUInt8 key, CkCallback cb );
+
+    //! Load the transfer plan from file
+    void loadPlan( const std::string& prefix, CmiUInt8 key, CkCallback cb );
+
+    //! Migrate to balance the load measured during transfers
+    void balance( CkCallback cb );
+
+    //! Set the load measured during transfers for the load balancer
+    void UserSetLBLoad() override;
+
+    //! Resume after load balancing
+    void ResumeFromSync() override;
 
     /** @name Charm++ pack/unpack serializer member functions */
     ///@{
@@ -147,17 +196,24 @@ class MeshArray : public CBase_MeshArray {
       p | m_meshwriter;
       p | m_el;
       if (p.isUnpacking()) {
-        m_inpoel = std::get< 0 >( m_el );
         m_gid = std::get< 1 >( m_el );
         m_lid = std::get< 2 >( m_el );
       }
+      p | m_inpoel;
       p | m_coord;
       p | m_nodeCommMap;
       p | m_edgeCommMap;
       p | m_bface;
       p | m_triinpoel;
       p | m_bnode;
+      p | m_surftri;
+      p | m_srcelem;
+      p | m_destnode;
       p | m_u;
+      p | m_centroid;
+      p | m_ue;
+      p | m_transfer;
+      p | m_balancecb;
     }
     //! \brief Pack/Unpack serialize operator|
     //! \param[in,out] p Charm++'s PUP::er serializer object reference
@@ -191,10 +247,11 @@ class MeshArray : public CBase_MeshArray {
     //! \details Initialized by the constructor. The first vector is the element
     //!   connectivity (local IDs), the second vector is the global node IDs of
     //!   owned elements, while the third one is a map of global->local node
-    //!   IDs.
+    //!   IDs. The element connectivity is only used during setup and then
+    //!   replaced by m_inpoel.
     tk::UnsMesh::Chunk m_el;
-    //! Alias to element connectivity
-    std::vector< std::size_t >& m_inpoel = std::get<0>( m_el );
+    //! Element connectivity with local node IDs
+    std::vector< tk::lindex > m_inpoel;
     //! Alias to global node IDs of owned elements
     std::vector< std::size_t >& m_gid = std::get<1>( m_el );
     //! \brief Alias to local node ids associated to the global ones of owned
@@ -214,11 +271,36 @@ class MeshArray : public CBase_MeshArray {
     std::vector< std::size_t > m_triinpoel;
     //! Boundary node lists mapped to side set ids
     std::map< int, std::vector< std::size_t > > m_bnode;
+    //! Side set triangle connectivity with local node IDs, the source of a
+    //! surface transfer
+    std::vector< tk::lindex > m_surftri;
+    //! Source elements (tets, or m_surftri triangles in a surface transfer)
+    //! in the region of interest, if the source is restricted to it
+    std::vector< tk::lindex > m_srcelem;
+    //! Local IDs of the nodes transferred into, if not all: the side set
+    //! nodes in a surface transfer, and only those in the region of interest
+    std::vector< tk::lindex > m_destnode;
     //! Solution in mesh nodes
     tk::Fields m_u;
+    //! Cell centroids, receiving cell-centered fields (+m2m_cellfield)
+    tk::UnsMesh::Coords m_centroid;
+    //! Solution in mesh cells and its gradient, 4 components (+m2m_cellfield)
+    tk::Fields m_ue;
+    //! Handle of the transfer in progress into this mesh chunk
+    TransferHandle m_transfer;
+    //! Callback to call after load balancing
+    CkCallback m_balancecb;
+    //! Time step read in the background, swapped into m_u by nextStep()
+    std::vector< tk::real > m_next;
+    //! Ticket of the background read into m_next, 0 if none in progress
+    //! \note Not migrated: chares do not migrate while reading time steps
+    uint64_t m_readticket;
 
     //! Set mesh coordinates based on coordinates map
     tk::UnsMesh::Coords setCoord( const tk::UnsMesh::CoordMap& coordmap );
+
+    //! Select the source elements and dest nodes of the region of interest
+    void selectRegion();
 };
 
 } // exam2m::
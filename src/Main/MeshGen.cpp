@@ -0,0 +1,195 @@
+// *****************************************************************************
+/*!
+  \file      src/Main/MeshGen.cpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Synthetic tetrahedron mesh generator, Charm++ main chare.
+  \details   Synthetic tetrahedron mesh generator, Charm++ main chare. This
+    executable generates structured or randomly perturbed tetrahedron meshes
+    of boxes and spheres of arbitrary size and writes them to ExodusII files,
+    to be used as inputs for benchmarking the mesh-to-mesh transfer, e.g.,
+    weak and strong scaling studies, without having to ship large mesh files.
+    Usage:
+
+      meshgen [-o file.exo] [-n nx,ny,nz | -ntet N]
+              [-box xmin,xmax,ymin,ymax,zmin,zmax]
+              [-sphere cx,cy,cz,r] [-jitter f] [-seed s]
+
+    -o       Output file name (default: box.exo)
+    -n       Number of hexahedral cells in the x, y, and z directions, each
+             split into 6 tetrahedra (default: 10,10,10)
+    -ntet    Approximate number of tetrahedra to generate, overriding -n, with
+             the cells sized about the same in all directions
+    -box     Extents of the box meshed (default: 0,1,0,1,0,1, or the bounding
+             box of the sphere if -sphere is given)
+    -sphere  Only keep tetrahedra inside the sphere given by its center and
+             radius, e.g., -box -1,1,-1,1,-1,1 for one mesh and -sphere
+             0,0,0,0.5 for another yields a sphere-in-box configuration
+    -jitter  Randomly perturb interior nodes by at most the given fraction of
+             the cell size (default: 0)
+    -seed    Seed of the random perturbation (default: 0)
+
+    In Charm++'s SMP mode nodes and elements are generated in parallel by the
+    worker threads of the node.
+*/
+// *****************************************************************************
+
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include "Types.hpp"
+#include "Timer.hpp"
+#include "Exception.hpp"
+#include "ProcessException.hpp"
+#include "Generator.hpp"
+#include "ExodusIIMeshWriter.hpp"
+#include "ParallelFor.hpp"
+#include "NoWarning/charm.hpp"
+
+#include "NoWarning/meshgen.decl.h"
+
+namespace {
+
+//! Parse a comma-separated list of numbers given as a command line argument
+//! \tparam T Type of numbers to parse
+//! \tparam N Number of numbers to parse
+//! \param[in] flag Command line flag the argument belongs to (for errors)
+//! \param[in] arg Command line argument to parse
+//! \return Array of numbers parsed
+template< class T, std::size_t N >
+std::array< T, N > parseList( const std::string& flag, const std::string& arg )
+{
+  std::array< T, N > v;
+  std::stringstream ss( arg );
+  std::string s;
+  for (std::size_t i=0; i<N; ++i) {
+    ErrChk( std::getline( ss, s, ',' ),
+            flag + " requires " + std::to_string(N) + " comma-separated "
+            "values, got: " + arg );
+    std::stringstream( s ) >> v[i];
+  }
+  ErrChk( !std::getline( ss, s, ',' ),
+          flag + " requires " + std::to_string(N) + " values, got: " + arg );
+  return v;
+}
+
+} // ::
+
+//! Charm++ main chare for the meshgen executable.
+class MeshGen : public CBase_MeshGen {
+
+  public:
+    //! Constructor: parse command line arguments
+    MeshGen( CkArgMsg* msg )
+    try :
+      m_signal( tk::setSignalHandlers() ),
+      m_file( "box.exo" ),
+      m_n{{ 10, 10, 10 }},
+      m_ntet( 0 ),
+      m_box{{ 0.0, 1.0, 0.0, 1.0, 0.0, 1.0 }},
+      m_sphere{{ 0.0, 0.0, 0.0, 0.0 }},
+      m_jitter( 0.0 ),
+      m_seed( 0 )
+    {
+      bool box = false;
+      for (int i=1; i<msg->argc; ++i) {
+        std::string flag( msg->argv[i] );
+        ErrChk( i+1 < msg->argc, "Missing value for argument " + flag );
+        std::string arg( msg->argv[++i] );
+        if (flag == "-o")
+          m_file = arg;
+        else if (flag == "-n")
+          m_n = parseList< std::size_t, 3 >( flag, arg );
+        else if (flag == "-ntet")
+          m_ntet = parseList< std::size_t, 1 >( flag, arg )[0];
+        else if (flag == "-box") {
+          m_box = parseList< tk::real, 6 >( flag, arg );
+          box = true;
+        }
+        else if (flag == "-sphere")
+          m_sphere = parseList< tk::real, 4 >( flag, arg );
+        else if (flag == "-jitter")
+          m_jitter = parseList< tk::real, 1 >( flag, arg )[0];
+        else if (flag == "-seed")
+          m_seed = parseList< uint64_t, 1 >( flag, arg )[0];
+        else
+          Throw( "Unknown argument: " + flag );
+      }
+      delete msg;
+
+      // Default to the bounding box of the sphere
+      if (m_sphere[3] > 0.0 && !box)
+        for (std::size_t d=0; d<3; ++d) {
+          m_box[d*2+0] = m_sphere[d] - m_sphere[3];
+          m_box[d*2+1] = m_sphere[d] + m_sphere[3];
+        }
+      for (std::size_t d=0; d<3; ++d)
+        ErrChk( m_box[d*2+1] > m_box[d*2], "Box extents must be increasing" );
+
+      // Initialize CkLoop used by tk::parallelFor on the worker threads
+      tk::initParallelFor();
+
+      thisProxy.generate();
+    } catch (...) { tk::processExceptionCharm(); }
+
+    //! Migrate constructor
+    explicit MeshGen( CkMigrateMessage* msg ) : CBase_MeshGen( msg ),
+      m_signal( tk::setSignalHandlers() ) {}
+
+    //! Generate mesh, write it to file, and exit
+    void generate() {
+      try {
+        tk::Timer t;
+
+        // Size cells about the same in all directions to yield the number of
+        // tetrahedra requested, accounting for the fraction of the box that
+        // is inside the sphere (if any)
+        if (m_ntet > 0) {
+          auto vol = (m_box[1]-m_box[0]) * (m_box[3]-m_box[2]) *
+                     (m_box[5]-m_box[4]);
+          auto ncell = static_cast< tk::real >( m_ntet ) / 6.0;
+          if (m_sphere[3] > 0.0)
+            ncell *= vol /
+              (4.0/3.0 * std::acos(-1.0) * std::pow( m_sphere[3], 3.0 ));
+          auto h = std::cbrt( vol / ncell );
+          for (std::size_t d=0; d<3; ++d)
+            m_n[d] = std::max< std::size_t >( 1, static_cast< std::size_t >(
+                       std::lround( (m_box[d*2+1]-m_box[d*2]) / h ) ) );
+        }
+
+        std::vector< std::size_t > inpoel;
+        tk::UnsMesh::Coords coord;
+        tk::genBoxMesh( m_n, m_box, m_jitter, m_seed, inpoel, coord );
+        if (m_sphere[3] > 0.0)
+          tk::carveSphere( {{ m_sphere[0], m_sphere[1], m_sphere[2] }},
+                           m_sphere[3], inpoel, coord );
+        auto gen = t.dsec();
+
+        CkPrintf( "MeshGen> Generated %zu tetrahedra, %zu nodes in %f sec\n",
+                  inpoel.size()/4, coord[0].size(), gen );
+
+        tk::ExodusIIMeshWriter( m_file, tk::ExoWriter::CREATE ).
+          writeMesh< 4 >( inpoel, coord );
+
+        CkPrintf( "MeshGen> Written '%s' in %f sec\n", m_file.c_str(),
+                  t.dsec() - gen );
+        CkExit();
+      } catch (...) { tk::processExceptionCharm(); }
+    }
+
+  private:
+    int m_signal;                       //!< Used to set signal handlers
+    std::string m_file;                 //!< Output file name
+    std::array< std::size_t, 3 > m_n;   //!< Number of cells in x, y, z
+    std::size_t m_ntet;                 //!< Approximate number of tets (if >0)
+    std::array< tk::real, 6 > m_box;    //!< Box extents
+    std::array< tk::real, 4 > m_sphere; //!< Sphere center and radius (if r>0)
+    tk::real m_jitter;                  //!< Node perturbation / cell size
+    uint64_t m_seed;                    //!< Seed of node perturbation
+};
+
+#include "NoWarning/meshgen.def.h"
@@ -0,0 +1,162 @@
+// *****************************************************************************
+/*!
+  \file      src/Main/ProbeArray.cpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     ProbeArray chare array holding part of a cloud of probe points
+  \details   ProbeArray chare array holding part of a cloud of probe points.
+*/
+// *****************************************************************************
+
+#include <string>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "ProbeArray.hpp"
+#include "Exception.hpp"
+
+namespace exam2m {
+
+extern int g_mode;
+extern bool g_reuseweights;
+
+}
+
+using exam2m::ProbeArray;
+
+ProbeArray::ProbeArray( const tk::UnsMesh::Coords& coord,
+                        CkCallback created,
+                        CkCallback cb ) :
+  m_coord( coord ),
+  m_u( coord[0].size(), 1 ),
+  m_cb( cb ),
+  m_nout( 0 )
+// *****************************************************************************
+//  Constructor
+//! \param[in] coord Coordinates of the probe points of this chare
+//! \param[in] created Callback to contribute to once created
+//! \param[in] cb Callback to contribute to once the solution at the probe
+//!   points is updated by a transfer
+// *****************************************************************************
+{
+  Assert( !coord[0].empty(), "No points assigned to ProbeArray chare" );
+  ErrChk( m_coord[0].size() <= std::numeric_limits< tk::lindex >::max(),
+          "Too many probe points for the local index type, reconfigure with "
+          "-DLOCAL_INDEX=64 or use more chares" );
+
+  // Points that are not found in the source mesh keep this value
+  for (std::size_t p=0; p<m_u.nunk(); ++p) m_u(p,0,0) = -1.0;
+
+  contribute( created );
+}
+
+void ProbeArray::setSolution( Solution& s, CkCallback cb )
+// *****************************************************************************
+//  Set the solution at the probe points
+//! \param[in] s Solution to evaluate at the probe points
+//! \param[in] cb Callback to contribute to once set
+// *****************************************************************************
+{
+  for (std::size_t p=0; p<m_u.nunk(); ++p)
+    m_u(p,0,0) = s.f( m_coord[0][p], m_coord[1][p], m_coord[2][p] );
+
+  contribute( cb );
+}
+
+void ProbeArray::checkSolution( Solution& s, CkCallback cb )
+// *****************************************************************************
+//  Check the solution at the probe points against the exact solution
+//! \param[in] s Exact solution
+//! \param[in] cb Callback to contribute the number of points holding a value to
+//! \details Points that received no value hold NaN, see UnsetSolution, and
+//!   are only skipped. All others must match the exact solution up to
+//!   roundoff, see MeshArray::checkSolution().
+// *****************************************************************************
+{
+  std::size_t n = 0;
+  for (std::size_t p=0; p<m_u.nunk(); ++p) {
+    if (std::isnan( m_u(p,0,0) )) continue;
+    ++n;
+    auto expected = s.f( m_coord[0][p], m_coord[1][p], m_coord[2][p] );
+    auto diff = std::abs( m_u(p,0,0) - expected );
+    if (diff > std::numeric_limits< float >::epsilon() *
+               std::max( 1.0, std::abs(expected) ))
+      CkAbort( "Probe %zu/%zu (%f %f %f) DIFF TOO BIG! %f - %f = %e\n",
+               p, m_u.nunk(), m_coord[0][p], m_coord[1][p], m_coord[2][p],
+               expected, m_u(p,0,0), diff );
+  }
+
+  contribute( sizeof(std::size_t), &n, CkReduction::sum_ulong, cb );
+}
+
+void ProbeArray::transferDest()
+// *****************************************************************************
+//  Start a transfer into the probe points
+//! \details The probe points are registered with the transfer library the
+//!   same way as the nodes of a destination mesh. Interpolation weights are
+//!   collected if the meshes reuse theirs in later iterations, since then the
+//!   probes apply theirs too, see applyDest().
+// *****************************************************************************
+{
+  m_transfer = exam2m::startTransfer(thisProxy, thisIndex, &m_coord, m_u,
+    CkCallback(CkIndex_ProbeArray::transferArrived(), thisProxy[thisIndex]),
+    g_reuseweights || g_mode == 4);
+}
+
+void ProbeArray::transferArrived()
+// *****************************************************************************
+//  All solution data of the transfer arrived, apply it to m_u
+// *****************************************************************************
+{
+  exam2m::waitTransfer(m_transfer,
+    CkCallback(CkIndex_ProbeArray::probed(), thisProxy[thisIndex]));
+}
+
+void ProbeArray::applyDest()
+// *****************************************************************************
+//  Apply the weights of the last transfer to the source values received
+// *****************************************************************************
+{
+  exam2m::applyDest(thisProxy, thisIndex, m_u,
+    CkCallback(CkIndex_ProbeArray::probed(), thisProxy[thisIndex]));
+}
+
+void ProbeArray::probed()
+// *****************************************************************************
+//  The solution at the probe points has been updated
+// *****************************************************************************
+{
+  contribute( m_cb );
+}
+
+void ProbeArray::out( tk::real t, CkCallback cb )
+// *****************************************************************************
+//  Append the solution at the probe points to file
+//! \param[in] t Physical time of the solution
+//! \param[in] cb Callback to contribute to once written
+//! \details Each chare writes its own CSV file, exam2m.probes.<chare>.csv,
+//!   with a line per point and output, which is truncated by the first output
+//!   of the run.
+// *****************************************************************************
+{
+  const auto file = "exam2m.probes." + std::to_string( thisIndex ) + ".csv";
+  std::ofstream csv( file, m_nout ? std::ios::app : std::ios::trunc );
+  ErrChk( csv.good(), "Failed to open file " + file );
+  if (m_nout == 0) csv << "t,x,y,z,u\n";
+  csv << std::setprecision( 16 );
+  const auto& x = m_coord[0];
+  const auto& y = m_coord[1];
+  const auto& z = m_coord[2];
+  for (std::size_t p=0; p<x.size(); ++p)
+    csv << t << ',' << x[p] << ',' << y[p] << ',' << z[p] << ','
+        << m_u(p,0,0) << '\n';
+  ErrChk( csv.good(), "Failed to write file " + file );
+  ++m_nout;
+
+  contribute( cb );
+}
+
+#include "NoWarning/probearray.def.h"
@@ -0,0 +1,102 @@
+// *****************************************************************************
+/*!
+  \file      src/Main/ProbeArray.hpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Chare class declaration for probearrays holding probe points
+  \details   Chare class declaration for probearrays holding part of a cloud
+     of probe points, e.g., sensor locations, at which the solution of the
+     source mesh is sampled by the transfer library. Unlike a mesh, probe
+     points need no partitioning, communication maps, or connectivity, so
+     they are distributed to chares in Morton order and passed to the
+     transfer library as a destination directly.
+*/
+// *****************************************************************************
+#ifndef ProbeArray_h
+#define ProbeArray_h
+
+#include "Types.hpp"
+#include "PUPUtil.hpp"
+#include "UnsMesh.hpp"
+#include "Fields.hpp"
+#include "Controller.hpp"
+#include "MeshArray.hpp"
+
+#include "NoWarning/probearray.decl.h"
+
+namespace exam2m {
+
+//! ProbeArray chare array holding part of a cloud of probe points
+class ProbeArray : public CBase_ProbeArray {
+
+  public:
+    //! Constructor
+    explicit ProbeArray( const tk::UnsMesh::Coords& coord,
+                         CkCallback created,
+                         CkCallback cb );
+
+    #if defined(__clang__)
+      #pragma clang diagnostic push
+      #pragma clang diagnostic ignored "-Wundefined-func-template"
+    #endif
+    //! Migrate constructor
+    // cppcheck-suppress uninitMemberVar
+    explicit ProbeArray( CkMigrateMessage* ) {}
+    #if defined(__clang__)
+      #pragma clang diagnostic pop
+    #endif
+
+    //! Set the solution at the probe points
+    void setSolution( Solution& s, CkCallback cb );
+
+    //! Check the solution at the probe points against the exact solution
+    void checkSolution( Solution& s, CkCallback cb );
+
+    //! Start a transfer into the probe points
+    void transferDest();
+
+    //! All solution data of the transfer arrived, apply it
+    void transferArrived();
+
+    //! Apply the weights of the last transfer to the source values received
+    void applyDest();
+
+    //! The solution at the probe points has been updated
+    void probed();
+
+    //! Append the solution at the probe points to file
+    void out( tk::real t, CkCallback cb );
+
+    /** @name Charm++ pack/unpack serializer member functions */
+    ///@{
+    //! \brief Pack/Unpack serialize member function
+    //! \param[in,out] p Charm++'s PUP::er serializer object reference
+    void pup( PUP::er &p ) override {
+      p | m_coord;
+      p | m_u;
+      p | m_cb;
+      p | m_transfer;
+      p | m_nout;
+    }
+    //! \brief Pack/Unpack serialize operator|
+    //! \param[in,out] p Charm++'s PUP::er serializer object reference
+    //! \param[in,out] i ProbeArray object reference
+    friend void operator|( PUP::er& p, ProbeArray& i ) { i.pup(p); }
+    //@}
+
+  private:
+    //! Probe point coordinates
+    tk::UnsMesh::Coords m_coord;
+    //! Solution at the probe points
+    tk::Fields m_u;
+    //! Callback to call once the solution at the probe points is updated
+    CkCallback m_cb;
+    //! Handle of the transfer in progress into the probe points
+    TransferHandle m_transfer;
+    //! Number of outputs written to file
+    uint64_t m_nout;
+};
+
+} // exam2m::
+
+#endif // ProbeArray_h
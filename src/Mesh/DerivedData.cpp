@@ -22,11 +22,14 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <iostream>
+#include <atomic>
+#include <memory>
 
 #include "Exception.hpp"
 #include "DerivedData.hpp"
 #include "ContainerUtil.hpp"
 #include "Vector.hpp"
+#include "ParallelFor.hpp"
 
 namespace tk {
 
@@ -1684,4 +1687,299 @@ conforming( const std::vector< std::size_t >& inpoel,
   return true;
 }
 
+static void
+prefixSum( std::vector< std::size_t >& v )
+// *****************************************************************************
+//  Compute inclusive prefix sum in place in parallel on the logical node
+//! \param[in,out] v Vector to replace with its inclusive prefix sum
+//! \details The vector is split into blocks, whose partial sums are computed
+//!   in parallel, then the block offsets are computed serially and finally
+//!   added in parallel.
+// *****************************************************************************
+{
+  auto n = v.size();
+  std::size_t nblock = 4 * parallelWidth();
+  if (nblock < 2 || n < 2*4096) {
+    std::partial_sum( begin(v), end(v), begin(v) );
+    return;
+  }
+  auto bsize = (n + nblock - 1) / nblock;
+  std::vector< std::size_t > offset( nblock+1, 0 );
+  parallelFor( nblock, [&]( std::size_t first, std::size_t last ){
+    for (auto b=first; b<last; ++b) {
+      auto beg = std::min( b*bsize, n ), fin = std::min( beg+bsize, n );
+      if (beg == fin) continue;
+      auto i0 = std::next( begin(v), static_cast< std::ptrdiff_t >( beg ) );
+      auto i1 = std::next( begin(v), static_cast< std::ptrdiff_t >( fin ) );
+      std::partial_sum( i0, i1, i0 );
+      offset[b+1] = v[fin-1];
+    }
+  }, 1 );
+  std::partial_sum( begin(offset), end(offset), begin(offset) );
+  parallelFor( nblock, [&]( std::size_t first, std::size_t last ){
+    for (auto b=first; b<last; ++b)
+      for (auto i=std::min(b*bsize,n); i<std::min((b+1)*bsize,n); ++i)
+        v[i] += offset[b];
+  }, 1 );
+}
+
+std::pair< std::vector< std::size_t >, std::vector< std::size_t > >
+genEsupPar( const std::vector< std::size_t >& inpoel, std::size_t nnpe )
+// *****************************************************************************
+//  Generate elements surrounding points in parallel on the logical node
+//! \param[in] inpoel Inteconnectivity of points and elements
+//! \param[in] nnpe Number of nodes per element
+//! \return Linked lists storing elements surrounding points, identical to
+//!   those generated by tk::genEsup()
+//! \details The counting pass over elements increments the per-point counters
+//!   atomically, the prefix sum is done in blocks, and the storage pass
+//!   reserves slots in the linked list atomically. Finally the element ids
+//!   of each point are sorted (in parallel over points), which yields the same
+//!   order as the serial storage pass in tk::genEsup().
+// *****************************************************************************
+{
+  Assert( !inpoel.empty(), "Attempt to call genEsupPar() on empty container" );
+  Assert( nnpe > 0, "Attempt to call genEsupPar() with zero nodes per element" );
+  Assert( inpoel.size()%nnpe == 0, "Size of inpoel must be divisible by nnpe" );
+
+  auto npoin = npoin_in_graph( inpoel );
+  auto nelem = inpoel.size()/nnpe;
+
+  // element pass 1: count number of elements connected to each point
+  std::unique_ptr< std::atomic< std::size_t >[] >
+    cnt( new std::atomic< std::size_t >[ npoin ] );
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    for (auto p=first; p<last; ++p) cnt[p].store( 0, std::memory_order_relaxed );
+  } );
+  parallelFor( nelem, [&]( std::size_t first, std::size_t last ){
+    for (auto i=first*nnpe; i<last*nnpe; ++i)
+      cnt[ inpoel[i] ].fetch_add( 1, std::memory_order_relaxed );
+  } );
+
+  // storage/reshuffling pass 1: prefix sum of the counters
+  std::vector< std::size_t > esup2( npoin+1, 0 );
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    for (auto p=first; p<last; ++p) {
+      esup2[p+1] = cnt[p].load( std::memory_order_relaxed );
+      cnt[p].store( 0, std::memory_order_relaxed );
+    }
+  } );
+  prefixSum( esup2 );
+
+  // store the elements in esup1
+  std::vector< std::size_t > esup1( esup2.back()+1, 0 );
+  parallelFor( nelem, [&]( std::size_t first, std::size_t last ){
+    for (auto i=first*nnpe; i<last*nnpe; ++i) {
+      auto n = inpoel[i];
+      auto j = esup2[n] + 1 + cnt[n].fetch_add( 1, std::memory_order_relaxed );
+      esup1[j] = i/nnpe;
+    }
+  } );
+
+  // sort element ids for each point in esup1
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    for (auto p=first; p<last; ++p)
+      std::sort(
+        std::next( begin(esup1), static_cast<std::ptrdiff_t>(esup2[p]+1) ),
+        std::next( begin(esup1), static_cast<std::ptrdiff_t>(esup2[p+1]+1) ) );
+  } );
+
+  // Return (move out) linked lists
+  return std::make_pair( std::move(esup1), std::move(esup2) );
+}
+
+//! Collect the sorted unique ids of points connected to point p via elements
+//! \param[in] inpoel Inteconnectivity of points and elements
+//! \param[in] nnpe Number of nodes per element
+//! \param[in] esup Elements surrounding points
+//! \param[in] p Point whose surrounding points to collect
+//! \param[in] above If true, only collect points with ids larger than p
+//! \param[in,out] q Vector to store the surrounding points in
+static void
+pointsAround( const std::vector< std::size_t >& inpoel,
+              std::size_t nnpe,
+              const std::pair< std::vector< std::size_t >,
+                               std::vector< std::size_t > >& esup,
+              std::size_t p,
+              bool above,
+              std::vector< std::size_t >& q )
+{
+  const auto& esup1 = esup.first;
+  const auto& esup2 = esup.second;
+  q.clear();
+  for (std::size_t i=esup2[p]+1; i<=esup2[p+1]; ++i)
+    for (std::size_t n=0; n<nnpe; ++n) {
+      auto r = inpoel[ esup1[i] * nnpe + n ];
+      if (r != p && (!above || r > p)) q.push_back( r );
+    }
+  tk::unique( q );
+}
+
+std::pair< std::vector< std::size_t >, std::vector< std::size_t > >
+genPsupPar( const std::vector< std::size_t >& inpoel,
+            std::size_t nnpe,
+            const std::pair< std::vector< std::size_t >,
+                             std::vector< std::size_t > >& esup )
+// *****************************************************************************
+//  Generate points surrounding points in parallel on the logical node
+//! \param[in] inpoel Inteconnectivity of points and elements
+//! \param[in] nnpe Number of nodes per element
+//! \param[in] esup Elements surrounding points as linked lists, see tk::genEsup
+//! \return Linked lists storing points surrounding points, identical to those
+//!   generated by tk::genPsup()
+//! \details The points surrounding each point are collected twice, in
+//!   parallel over points: the first pass counts them, which after a prefix
+//!   sum gives the storage offsets, and the second pass stores them.
+// *****************************************************************************
+{
+  Assert( !inpoel.empty(), "Attempt to call genPsupPar() on empty container" );
+  Assert( nnpe > 0, "Attempt to call genPsupPar() with zero nodes per element" );
+  Assert( inpoel.size()%nnpe == 0, "Size of inpoel must be divisible by nnpe" );
+  Assert( !esup.first.empty(), "Attempt to call genPsupPar() with empty esup1" );
+  Assert( !esup.second.empty(), "Attempt to call genPsupPar() with empty esup2" );
+
+  auto npoin = npoin_in_graph( inpoel );
+
+  // point pass 1: count number of points surrounding each point
+  std::vector< std::size_t > psup2( npoin+1, 0 );
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    std::vector< std::size_t > q;
+    for (auto p=first; p<last; ++p) {
+      pointsAround( inpoel, nnpe, esup, p, false, q );
+      psup2[p+1] = q.size();
+    }
+  }, 1024 );
+  prefixSum( psup2 );
+
+  // point pass 2: store the points surrounding each point
+  std::vector< std::size_t > psup1( psup2.back()+1, 0 );
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    std::vector< std::size_t > q;
+    for (auto p=first; p<last; ++p) {
+      pointsAround( inpoel, nnpe, esup, p, false, q );
+      std::copy( begin(q), end(q),
+        std::next( begin(psup1), static_cast<std::ptrdiff_t>(psup2[p]+1) ) );
+    }
+  }, 1024 );
+
+  // Return (move out) linked lists
+  return std::make_pair( std::move(psup1), std::move(psup2) );
+}
+
+std::pair< std::vector< std::size_t >, std::vector< std::size_t > >
+genEdsupPar( const std::vector< std::size_t >& inpoel,
+             std::size_t nnpe,
+             const std::pair< std::vector< std::size_t >,
+                              std::vector< std::size_t > >& esup )
+// *****************************************************************************
+//  Generate edges surrounding points in parallel on the logical node
+//! \param[in] inpoel Inteconnectivity of points and elements
+//! \param[in] nnpe Number of nodes per element (3 or 4)
+//! \param[in] esup Elements surrounding points as linked lists, see tk::genEsup
+//! \return Linked lists storing edges (point ids p < q) emanating from points,
+//!   identical to those generated by tk::genEdsup()
+//! \details Similar to tk::genPsupPar(), but only storing end-points q > p.
+//!   To reproduce the layout of tk::genEdsup(), the index array only has
+//!   entries for points that have edges, padded at the end with the last
+//!   index. This compaction is the only serial pass over the points.
+// *****************************************************************************
+{
+  Assert( !inpoel.empty(), "Attempt to call genEdsupPar() on empty container" );
+  Assert( nnpe == 3 || nnpe == 4,
+          "Attempt to call genEdsupPar() with nodes per element, nnpe, that is "
+          "neither 4 (tetrahedra) nor 3 (triangles)." );
+  Assert( inpoel.size()%nnpe == 0, "Size of inpoel must be divisible by nnpe" );
+  Assert( !esup.first.empty(), "Attempt to call genEdsupPar() with empty esup1" );
+  Assert( !esup.second.empty(),
+          "Attempt to call genEdsupPar() with empty esup2" );
+
+  auto npoin = npoin_in_graph( inpoel );
+
+  // point pass 1: count number of edges p < q emanating from each point
+  std::vector< std::size_t > cnt( npoin, 0 ), offset( npoin+1, 0 );
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    std::vector< std::size_t > q;
+    for (auto p=first; p<last; ++p) {
+      pointsAround( inpoel, nnpe, esup, p, true, q );
+      cnt[p] = offset[p+1] = q.size();
+    }
+  }, 1024 );
+  prefixSum( offset );
+
+  // point pass 2: store the end-points of edges emanating from each point
+  std::vector< std::size_t > edsup1( offset.back()+1, 0 );
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    std::vector< std::size_t > q;
+    for (auto p=first; p<last; ++p) {
+      pointsAround( inpoel, nnpe, esup, p, true, q );
+      std::copy( begin(q), end(q),
+        std::next( begin(edsup1), static_cast<std::ptrdiff_t>(offset[p]+1) ) );
+    }
+  }, 1024 );
+
+  // index array only for points with edges, padded with the last index
+  std::vector< std::size_t > edsup2( 1, 0 );
+  edsup2.reserve( npoin+1 );
+  for (std::size_t p=0; p<npoin; ++p)
+    if (cnt[p]) edsup2.push_back( offset[p+1] );
+  edsup2.resize( npoin+1, edsup2.back() );
+
+  // Return (move out) linked lists
+  return std::make_pair( std::move(edsup1), std::move(edsup2) );
+}
+
+std::vector< int >
+genEsuelTetPar( const std::vector< std::size_t >& inpoel,
+                const std::pair< std::vector< std::size_t >,
+                                 std::vector< std::size_t > >& esup )
+// *****************************************************************************
+//  Generate elements surrounding elements of tetrahedra, including boundary
+//  elements as -1, in parallel on the logical node
+//! \param[in] inpoel Inteconnectivity of points and elements
+//! \param[in] esup Elements surrounding points as linked lists, see tk::genEsup
+//! \return Vector storing elements surrounding elements, identical to that
+//!   generated by tk::genEsuelTet() for conforming meshes
+//! \details Unlike tk::genEsuelTet(), which also stores the face-neighbor
+//!   relation from the side of the neighbor, each element here only writes
+//!   its own entries, so that elements can be processed in parallel without
+//!   a shared marker array: the neighbor across a face is the element, other
+//!   than the element itself, that surrounds the first node of the face and
+//!   also contains its other two nodes.
+// *****************************************************************************
+{
+  Assert( !inpoel.empty(),
+          "Attempt to call genEsuelTetPar() on empty container" );
+  Assert( !esup.first.empty(),
+          "Attempt to call genEsuelTetPar() with empty esup1" );
+  Assert( !esup.second.empty(),
+          "Attempt to call genEsuelTetPar() with empty esup2" );
+  Assert( inpoel.size()%4 == 0, "Size of inpoel must be divisible by four" );
+
+  const auto& esup1 = esup.first;
+  const auto& esup2 = esup.second;
+  auto nelem = inpoel.size()/4;
+
+  std::vector< int > esuelTet( 4*nelem, -1 );
+
+  parallelFor( nelem, [&]( std::size_t first, std::size_t last ){
+    for (auto e=first; e<last; ++e) {
+      for (std::size_t fe=0; fe<4; ++fe) {
+        auto a = inpoel[e*4+lpofa[fe][0]];
+        auto b = inpoel[e*4+lpofa[fe][1]];
+        auto c = inpoel[e*4+lpofa[fe][2]];
+        for (std::size_t j=esup2[a]+1; j<=esup2[a+1]; ++j) {
+          auto jelem = esup1[j];
+          if (jelem == e) continue;
+          const auto* N = inpoel.data() + jelem*4;
+          auto has = [N]( std::size_t p ){
+            return N[0] == p || N[1] == p || N[2] == p || N[3] == p; };
+          if (has(b) && has(c)) esuelTet[e*4+fe] = static_cast< int >( jelem );
+        }
+      }
+    }
+  } );
+
+  return esuelTet;
+}
+
 } // tk::
@@ -191,6 +191,31 @@ conforming( const std::vector< std::size_t >& inpoel,
             const tk::UnsMesh::Coords& coord,
             bool cerr = true );
 
+//! Generate elements surrounding points in parallel on the logical node
+std::pair< std::vector< std::size_t >, std::vector< std::size_t > >
+genEsupPar( const std::vector< std::size_t >& inpoel, std::size_t nnpe );
+
+//! Generate points surrounding points in parallel on the logical node
+std::pair< std::vector< std::size_t >, std::vector< std::size_t > >
+genPsupPar( const std::vector< std::size_t >& inpoel,
+            std::size_t nnpe,
+            const std::pair< std::vector< std::size_t >,
+                             std::vector< std::size_t > >& esup );
+
+//! Generate edges surrounding points in parallel on the logical node
+std::pair< std::vector< std::size_t >, std::vector< std::size_t > >
+genEdsupPar( const std::vector< std::size_t >& inpoel,
+             std::size_t nnpe,
+             const std::pair< std::vector< std::size_t >,
+                              std::vector< std::size_t > >& esup );
+
+//! \brief Generate elements surrounding elements of tetrahedra, including
+//!   boundary elements as -1, in parallel on the logical node
+std::vector< int >
+genEsuelTetPar( const std::vector< std::size_t >& inpoel,
+                const std::pair< std::vector< std::size_t >,
+                                 std::vector< std::size_t > >& esup );
+
 } // tk::
 
 #endif // DerivedData_h
@@ -0,0 +1,224 @@
+// *****************************************************************************
+/*!
+  \file      src/Mesh/Generator.cpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Synthetic tetrahedron mesh generators
+  \details   Synthetic tetrahedron mesh generators used to create meshes of
+    arbitrary size for benchmarking, e.g., weak and strong scaling of the
+    mesh-to-mesh transfer, without having to ship large mesh files.
+*/
+// *****************************************************************************
+
+#include <limits>
+
+#include "Generator.hpp"
+#include "Exception.hpp"
+#include "ParallelFor.hpp"
+
+namespace tk {
+
+static real
+unitNoise( uint64_t seed, uint64_t key )
+// *****************************************************************************
+//  Hash a key to a pseudo-random number in [-1,1)
+//! \param[in] seed Seed of the random sequence
+//! \param[in] key Key to hash, e.g., combining node id and coordinate direction
+//! \return Pseudo-random number in [-1,1), the same for the same seed and key
+//! \details Uses the splitmix64 finalizer, so that the noise does not depend
+//!   on the order or the thread the nodes are generated on.
+// *****************************************************************************
+{
+  auto z = seed + 0x9e3779b97f4a7c15ULL * (key + 1);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z = z ^ (z >> 31);
+  return static_cast< real >( z >> 11 ) * 0x1.0p-52 - 1.0;
+}
+
+void
+genBoxMesh( const std::array< std::size_t, 3 >& n,
+            const std::array< real, 6 >& box,
+            real jitter,
+            uint64_t seed,
+            std::vector< std::size_t >& inpoel,
+            UnsMesh::Coords& coord )
+// *****************************************************************************
+//  Generate a tetrahedron mesh of an axis-aligned box
+//! \param[in] n Number of hexahedral cells in x, y, and z directions
+//! \param[in] box Extents of the box: xmin, xmax, ymin, ymax, zmin, zmax
+//! \param[in] jitter Magnitude of the random perturbation of interior nodes
+//!   as a fraction of the cell size (0: structured mesh)
+//! \param[in] seed Seed of the random perturbation of interior nodes
+//! \param[out] inpoel Tetrahedron element connectivity
+//! \param[out] coord Node coordinates
+//! \details Each hexahedral cell is split into 6 tetrahedra sharing the cell's
+//!   main diagonal (Kuhn triangulation), which yields a conforming mesh, as
+//!   all cells are split the same way. The result is a 6*n[0]*n[1]*n[2]
+//!   element mesh with all elements positively oriented. Interior nodes are
+//!   displaced by a random amount of at most jitter times the cell size in
+//!   each direction, while boundary nodes are only displaced along the
+//!   boundary, so the box keeps its shape. Jitter values up to about 0.2 keep
+//!   all tetrahedra valid. Nodes and elements are generated in parallel.
+// *****************************************************************************
+{
+  Assert( n[0] > 0 && n[1] > 0 && n[2] > 0, "Need at least one cell" );
+  ErrChk( jitter >= 0.0 && jitter < 0.5, "Jitter must be in [0,0.5)" );
+
+  const std::size_t nx = n[0]+1, ny = n[1]+1, nz = n[2]+1;
+  const auto npoin = nx * ny * nz;
+  const auto ncell = n[0] * n[1] * n[2];
+
+  const std::array< real, 3 >
+    h{{ (box[1]-box[0]) / static_cast< real >( n[0] ),
+        (box[3]-box[2]) / static_cast< real >( n[1] ),
+        (box[5]-box[4]) / static_cast< real >( n[2] ) }};
+
+  // Generate node coordinates
+  for (auto& c : coord) c.resize( npoin );
+  parallelFor( npoin, [&]( std::size_t first, std::size_t last ){
+    for (std::size_t p=first; p<last; ++p) {
+      const std::array< std::size_t, 3 >
+        ijk{{ p % nx, (p / nx) % ny, p / (nx*ny) }};
+      for (std::size_t d=0; d<3; ++d) {
+        auto x = box[d*2] + static_cast< real >( ijk[d] ) * h[d];
+        if (jitter > 0.0 && ijk[d] > 0 && ijk[d] < n[d])
+          x += jitter * h[d] * unitNoise( seed, p*3+d );
+        coord[d][p] = x;
+      }
+    }
+  } );
+
+  // Node offsets of hex cell corners, corner c has x, y, z offsets given by
+  // bits 0, 1, 2 of c
+  std::array< std::size_t, 8 > corner;
+  for (std::size_t c=0; c<8; ++c)
+    corner[c] = (c & 1) + ((c >> 1) & 1) * nx + ((c >> 2) & 1) * nx * ny;
+
+  // Kuhn triangulation: tets along paths from corner 0 to 7, one per
+  // permutation of the coordinate directions, odd permutations swapped to
+  // orient all tets positively
+  static const std::array< std::array< std::size_t, 4 >, 6 > kuhn{{
+    {{ 0, 1, 3, 7 }}, {{ 0, 2, 6, 7 }}, {{ 0, 4, 5, 7 }},
+    {{ 0, 1, 7, 5 }}, {{ 0, 2, 7, 3 }}, {{ 0, 4, 7, 6 }} }};
+
+  // Generate element connectivity
+  inpoel.resize( ncell * 24 );
+  parallelFor( ncell, [&]( std::size_t first, std::size_t last ){
+    for (std::size_t c=first; c<last; ++c) {
+      const auto i = c % n[0], j = (c / n[0]) % n[1], k = c / (n[0]*n[1]);
+      const auto base = (k*ny + j)*nx + i;
+      auto e = c*24;
+      for (const auto& t : kuhn)
+        for (auto v : t) inpoel[ e++ ] = base + corner[v];
+    }
+  } );
+}
+
+std::vector< std::size_t >
+genBoxHexes( const std::array< std::size_t, 3 >& n )
+// *****************************************************************************
+//  Generate the hexahedron connectivity of the cells of a box mesh
+//! \param[in] n Number of hexahedral cells in x, y, and z directions
+//! \return Hexahedron element connectivity, nodes in ExodusII order, of the
+//!   cells of the mesh generated by genBoxMesh() with the same n, whose node
+//!   coordinates it refers to, before they are split into tetrahedra
+// *****************************************************************************
+{
+  Assert( n[0] > 0 && n[1] > 0 && n[2] > 0, "Need at least one cell" );
+
+  const std::size_t nx = n[0]+1, ny = n[1]+1;
+  const auto ncell = n[0] * n[1] * n[2];
+
+  // Node offsets of hex cell corners in ExodusII order: counter-clockwise at
+  // the bottom, then at the top
+  std::array< std::size_t, 8 > corner;
+  static const std::array< std::size_t, 8 > exo{{ 0, 1, 3, 2, 4, 5, 7, 6 }};
+  for (std::size_t c=0; c<8; ++c)
+    corner[c] = (exo[c] & 1) + ((exo[c] >> 1) & 1) * nx +
+                ((exo[c] >> 2) & 1) * nx * ny;
+
+  std::vector< std::size_t > inpoel( ncell * 8 );
+  parallelFor( ncell, [&]( std::size_t first, std::size_t last ){
+    for (std::size_t c=first; c<last; ++c) {
+      const auto i = c % n[0], j = (c / n[0]) % n[1], k = c / (n[0]*n[1]);
+      const auto base = (k*ny + j)*nx + i;
+      for (std::size_t v=0; v<8; ++v) inpoel[ c*8+v ] = base + corner[v];
+    }
+  } );
+
+  return inpoel;
+}
+
+void
+carveSphere( const std::array< real, 3 >& center,
+             real radius,
+             std::vector< std::size_t >& inpoel,
+             UnsMesh::Coords& coord )
+// *****************************************************************************
+//  Keep only the tetrahedra whose centroid is inside a sphere
+//! \param[in] center Coordinates of the center of the sphere
+//! \param[in] radius Radius of the sphere
+//! \param[in,out] inpoel Tetrahedron element connectivity
+//! \param[in,out] coord Node coordinates
+//! \details Nodes no longer used by any tetrahedron are removed and the
+//!   remaining nodes renumbered, keeping their relative order. Applied to a
+//!   box mesh enclosing the sphere this yields a (staircase) sphere mesh, e.g.,
+//!   for sphere-in-box overlap configurations.
+// *****************************************************************************
+{
+  const auto nelem = inpoel.size() / 4;
+  const auto& x = coord[0];
+  const auto& y = coord[1];
+  const auto& z = coord[2];
+  const auto r2 = radius * radius;
+
+  // Flag tetrahedra to keep
+  std::vector< char > keep( nelem );
+  parallelFor( nelem, [&]( std::size_t first, std::size_t last ){
+    for (std::size_t e=first; e<last; ++e) {
+      real cx = 0.0, cy = 0.0, cz = 0.0;
+      for (std::size_t a=0; a<4; ++a) {
+        auto p = inpoel[e*4+a];
+        cx += x[p];  cy += y[p];  cz += z[p];
+      }
+      cx = cx/4.0 - center[0];
+      cy = cy/4.0 - center[1];
+      cz = cz/4.0 - center[2];
+      keep[e] = cx*cx + cy*cy + cz*cz < r2;
+    }
+  } );
+
+  // Compact element connectivity and flag used nodes
+  const auto npoin = x.size();
+  const auto unused = std::numeric_limits< std::size_t >::max();
+  std::vector< std::size_t > map( npoin, unused );
+  std::size_t ne = 0;
+  for (std::size_t e=0; e<nelem; ++e) {
+    if (!keep[e]) continue;
+    for (std::size_t a=0; a<4; ++a) {
+      auto p = inpoel[e*4+a];
+      inpoel[ne*4+a] = p;
+      map[p] = 0;
+    }
+    ++ne;
+  }
+  inpoel.resize( ne*4 );
+  ErrChk( ne > 0, "No elements inside sphere" );
+
+  // Renumber used nodes and compact coordinates
+  std::size_t np = 0;
+  for (std::size_t p=0; p<npoin; ++p) {
+    if (map[p] == unused) continue;
+    map[p] = np;
+    for (auto& c : coord) c[np] = c[p];
+    ++np;
+  }
+  for (auto& c : coord) {
+    c.resize( np );
+    c.shrink_to_fit();
+  }
+  for (auto& p : inpoel) p = map[p];
+}
+
+} // tk::
@@ -0,0 +1,47 @@
+// *****************************************************************************
+/*!
+  \file      src/Mesh/Generator.hpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Synthetic tetrahedron mesh generators
+  \details   Synthetic tetrahedron mesh generators used to create meshes of
+    arbitrary size for benchmarking, e.g., weak and strong scaling of the
+    mesh-to-mesh transfer, without having to ship large mesh files.
+*/
+// *****************************************************************************
+#ifndef Generator_h
+#define Generator_h
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "Types.hpp"
+#include "UnsMesh.hpp"
+
+namespace tk {
+
+//! Generate a tetrahedron mesh of an axis-aligned box
+void
+genBoxMesh( const std::array< std::size_t, 3 >& n,
+            const std::array< real, 6 >& box,
+            real jitter,
+            uint64_t seed,
+            std::vector< std::size_t >& inpoel,
+            UnsMesh::Coords& coord );
+
+//! Generate the hexahedron connectivity of the cells of a box mesh
+std::vector< std::size_t >
+genBoxHexes( const std::array< std::size_t, 3 >& n );
+
+//! Keep only the tetrahedra whose centroid is inside a sphere
+void
+carveSphere( const std::array< real, 3 >& center,
+             real radius,
+             std::vector< std::size_t >& inpoel,
+             UnsMesh::Coords& coord );
+
+} // tk::
+
+#endif // Generator_h
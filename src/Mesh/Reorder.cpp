@@ -10,7 +10,11 @@
 */
 // *****************************************************************************
 
+#include <numeric>
+#include <algorithm>
+
 #include "Reorder.hpp"
+#include "DerivedData.hpp"
 #include "ContainerUtil.hpp"
 #include "Exception.hpp"
 #include "Vector.hpp"
@@ -206,50 +210,115 @@ std::vector< std::size_t >
 renumber( const std::pair< std::vector< std::size_t >,
                            std::vector< std::size_t > >& psup )
 // *****************************************************************************
-//  Reorder mesh points with the advancing front technique
+//  Reorder mesh points with the reverse Cuthill-McKee technique
 //! \param[in] psup Points surrounding points
-//! \return Mapping created by renumbering (reordering)
+//! \return Mapping created by renumbering (reordering), old->new
+//! \details This is an advancing front (breadth-first) renumbering: each
+//!   front is started from the lowest-degree point not yet numbered and its
+//!   neighbors are appended in the order of increasing degree. The resulting
+//!   order is reversed (reverse Cuthill-McKee), which reduces the bandwidth of
+//!   the point-point graph, so that points referenced by the same element are
+//!   close in memory. Since the queue of numbered points is itself the
+//!   new->old map, the algorithm is O(npoin+nedge) and does not allocate per
+//!   front. Disconnected graphs are handled by restarting the front in the
+//!   next (unnumbered) component.
 // *****************************************************************************
 {
+  const auto& psup1 = psup.first;
+  const auto& psup2 = psup.second;
+
   // Find out number of nodes in graph
-  auto npoin = psup.second.size()-1;
-
-  // Construct mapping using advancing front
-  std::vector< int > hpoin( npoin, -1 ), lpoin( npoin, 0 );
-  std::vector< std::size_t > map( npoin, 0 );
-  hpoin[0] = 0;
-  lpoin[0] = 1;
-  std::size_t num = 1;
-  while (num < npoin) {
-    std::size_t cnt = 0;
-    std::size_t i = 0;
-    std::vector< int > kpoin( npoin, -1 );
-    int p;
-    while ((p = hpoin[i]) != -1) {
-      ++i;
-      auto P = static_cast< std::size_t >( p );
-      for (auto j=psup.second[P]+1; j<=psup.second[P+1]; ++j) {
-        auto q = psup.first[j];
-        if (lpoin[q] != 1) {    // consider points not yet counted
-          map[q] = num++;
-          kpoin[cnt] = static_cast< int >( q ); // register point as counted
-          lpoin[q] = 1;                         // register the point as counted
-          ++cnt;
+  auto npoin = psup2.size()-1;
+
+  auto degree = [&]( std::size_t p ){ return psup2[p+1] - psup2[p]; };
+  auto bydegree = [&]( std::size_t a, std::size_t b ){
+    return degree(a) < degree(b); };
+
+  // Candidate starting points of fronts in the order of increasing degree
+  std::vector< std::size_t > start( npoin );
+  std::iota( begin(start), end(start), 0 );
+  std::stable_sort( begin(start), end(start), bydegree );
+
+  // Construct new->old map using advancing front
+  std::vector< std::size_t > order;
+  order.reserve( npoin );
+  std::vector< char > counted( npoin, 0 );
+  std::size_t s = 0;
+  while (order.size() < npoin) {
+    // start new front in the next component from its lowest-degree point
+    while (counted[ start[s] ]) ++s;
+    auto head = order.size();
+    order.push_back( start[s] );
+    counted[ start[s] ] = 1;
+    while (head < order.size()) {
+      auto p = order[ head++ ];
+      auto front = order.size();
+      for (auto j=psup2[p]+1; j<=psup2[p+1]; ++j) {
+        auto q = psup1[j];
+        if (!counted[q]) {    // consider points not yet counted
+          order.push_back( q );
+          counted[q] = 1;     // register the point as counted
         }
       }
+      std::stable_sort( begin(order)+static_cast<long>(front), end(order),
+                        bydegree );
     }
-    hpoin = kpoin;
   }
 
-//   // Construct new->old id map
-//   std::size_t i = 0;
-//   std::vector< std::size_t > oldmap( npoin );
-//   for (auto n : map) oldmap[n] = i++;
+  // Construct old->new map reversing the Cuthill-McKee order
+  std::vector< std::size_t > map( npoin );
+  for (std::size_t i=0; i<npoin; ++i) map[ order[npoin-1-i] ] = i;
 
-  // Return old->new and new->old maps
+  // Return old->new map
   return map;
 }
 
+void
+reorder( std::vector< std::size_t >& inpoel,
+         std::vector< std::size_t >& gid,
+         std::unordered_map< std::size_t, std::size_t >& lid,
+         std::array< std::vector< real >, 3 >& coord )
+// *****************************************************************************
+//  Reorder nodes and elements of a tetrahedron mesh chunk for cache locality
+//! \param[in,out] inpoel Element connectivity with local node IDs
+//! \param[in,out] gid Local->global node id map
+//! \param[in,out] lid Global->local node id map
+//! \param[in,out] coord Node coordinates
+//! \details Nodes are renumbered by reverse Cuthill-McKee (see renumber()),
+//!   then elements are sorted by their lowest new node id, so that traversing
+//!   elements in order walks memory of node data (coordinates, fields)
+//!   approximately sequentially. All node-indexed data passed in is permuted
+//!   consistently; the local->global and global->local maps are updated so
+//!   that global ids continue to refer to the same nodes.
+// *****************************************************************************
+{
+  if (inpoel.empty()) return;
+
+  Assert( inpoel.size() % 4 == 0, "Size of inpoel must be divisible by 4" );
+  Assert( gid.size() == coord[0].size(), "Size mismatch" );
+
+  // Renumber nodes
+  auto map = renumber( genPsupPar( inpoel, 4, genEsupPar( inpoel, 4 ) ) );
+  remap( inpoel, map );
+  for (auto& c : coord) remap( c, map );
+  auto g = gid;
+  for (std::size_t i=0; i<map.size(); ++i) gid[ map[i] ] = g[i];
+  lid = assignLid( gid );
+
+  // Sort elements by their lowest node id
+  auto nelem = inpoel.size()/4;
+  std::vector< std::size_t > key( nelem ), elem( nelem );
+  for (std::size_t e=0; e<nelem; ++e)
+    key[e] = *std::min_element( begin(inpoel)+static_cast<long>(e*4),
+                                begin(inpoel)+static_cast<long>(e*4+4) );
+  std::iota( begin(elem), end(elem), 0 );
+  std::stable_sort( begin(elem), end(elem),
+    [&]( std::size_t a, std::size_t b ){ return key[a] < key[b]; } );
+  auto el = inpoel;
+  for (std::size_t e=0; e<nelem; ++e)
+    for (std::size_t i=0; i<4; ++i) inpoel[e*4+i] = el[ elem[e]*4+i ];
+}
+
 std::unordered_map< std::size_t, std::size_t >
 assignLid( const std::vector< std::size_t >& gid )
 // *****************************************************************************
@@ -56,11 +56,18 @@ std::map< int, std::vector< std::size_t > >
 remap( const std::map< int, std::vector< std::size_t > >& id,
        const std::unordered_map< std::size_t, std::size_t >& map );
 
-//! Reorder mesh points with the advancing front technique
+//! Reorder mesh points with the reverse Cuthill-McKee technique
 std::vector< std::size_t >
 renumber( const std::pair< std::vector< std::size_t >,
                            std::vector< std::size_t > >& psup );
 
+//! Reorder nodes and elements of a tetrahedron mesh chunk for cache locality
+void
+reorder( std::vector< std::size_t >& inpoel,
+         std::vector< std::size_t >& gid,
+         std::unordered_map< std::size_t, std::size_t >& lid,
+         std::array< std::vector< real >, 3 >& coord );
+
 //! Assign local ids to global ids
 std::unordered_map< std::size_t, std::size_t >
 assignLid( const std::vector< std::size_t >& gid );
@@ -0,0 +1,35 @@
+// *****************************************************************************
+/*!
+  \file      src/NoWarning/benchmark.def.h
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Include benchmark.def.h with turning off specific compiler
+             warnings
+*/
+// *****************************************************************************
+#ifndef nowarning_benchmark_def_h
+#define nowarning_benchmark_def_h
+
+#include "Macro.hpp"
+
+#if defined(__clang__)
+  #pragma clang diagnostic push
+  #pragma clang diagnostic ignored "-Wold-style-cast"
+  #pragma clang diagnostic ignored "-Wextra-semi"
+  #pragma clang diagnostic ignored "-Wmissing-prototypes"
+  #pragma clang diagnostic ignored "-Wunused-variable"
+  #pragma clang diagnostic ignored "-Wzero-as-null-pointer-constant"
+#elif defined(STRICT_GNUC)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wunused-variable"
+#endif
+
+#include "../Main/benchmark.def.h"
+
+#if defined(__clang__)
+  #pragma clang diagnostic pop
+#elif defined(STRICT_GNUC)
+  #pragma GCC diagnostic pop
+#endif
+
+#endif // nowarning_benchmark_def_h
@@ -2,8 +2,15 @@
 
 #include "Controller.hpp"
 #include "Worker.hpp"
+#include "Exception.hpp"
+#include "UnsMesh.hpp"
+#include "ParallelFor.hpp"
 
 #include <cassert>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
 
 namespace exam2m {
 
@@ -17,6 +24,28 @@ namespace exam2m {
 /* readonly */ CProxy_Controller controllerProxy;
 //! \brief Charm handle to the collision detection library instance
 /* readonly */ CollideHandle collideHandle;
+//! \brief Size in bytes above which aggregated messages are sent (0: off)
+/* readonly */ int g_aggregateBytes;
+//! \brief Time in milliseconds after which aggregated messages are sent
+/* readonly */ double g_aggregateTimeout;
+//! \brief Minimum number of collisions per thread processed in parallel
+/* readonly */ int g_parallelGrain;
+
+//!\brief Function called by the Charm++ scheduler to flush aggregated messages
+//!   when the PE becomes idle
+static void idleFlushHandler( void* param,
+                              [[maybe_unused]] double curWallTime )
+{
+  static_cast< Controller* >( param )->flushAggregates( true );
+}
+
+//!\brief Function called by the Charm++ scheduler to flush aggregated messages
+//!   when the flush timeout expires
+static void timerFlushHandler( void* param,
+                               [[maybe_unused]] double curWallTime )
+{
+  static_cast< Controller* >( param )->flushAggregates( false );
+}
 
 //!\brief Function called by charm collision library when it completes
 void collisionHandler( [[maybe_unused]] void *param,
@@ -42,18 +71,104 @@ void addMesh(CkArrayID p, int elem, CkCallback cb) {
   controllerProxy[0].addMesh(p, elem, cb);
 }
 
-void setSourceTets(CkArrayID p, int index, std::vector< std::size_t >* inpoel, tk::UnsMesh::Coords* coords, const tk::Fields& u) {
-  controllerProxy.ckLocalBranch()->setSourceTets(p, index, inpoel, coords, u);
+void setSourceTets(CkArrayID p, int index, std::vector< tk::lindex >* inpoel, tk::UnsMesh::Coords* coords, const tk::Fields& u, const std::vector< tk::lindex >* elems, SourceField field) {
+  controllerProxy.ckLocalBranch()->setSourceTets(p, index, inpoel, coords, u, elems, field);
+}
+
+void setSourceCells(CkArrayID p, int index, std::vector< tk::lindex >* inpoel, const std::vector< std::size_t >* cellptr, tk::UnsMesh::Coords* coords, const tk::Fields& u, const std::vector< tk::lindex >* elems, SourceField field) {
+  controllerProxy.ckLocalBranch()->setSourceCells(p, index, inpoel, cellptr, coords, u, elems, field);
+}
+
+void setSourceTris(CkArrayID p, int index, std::vector< tk::lindex >* triinpoel, tk::UnsMesh::Coords* coords, const tk::Fields& u, tk::real tol, const std::vector< tk::lindex >* elems) {
+  controllerProxy.ckLocalBranch()->setSourceTris(p, index, triinpoel, coords, u, tol, elems);
+}
+
+void setDestPoints(CkArrayID p, int index, tk::UnsMesh::Coords* coords, const tk::Fields& u, CkCallback cb, const std::vector< tk::lindex >* points) {
+  controllerProxy.ckLocalBranch()->setDestPoints(p, index, coords, u, cb, points);
+}
+
+TransferHandle startTransfer(CkArrayID p, int index, tk::UnsMesh::Coords* coords, tk::Fields& u, CkCallback cb, bool weights, const std::vector< tk::lindex >* points) {
+  return controllerProxy.ckLocalBranch()->startTransfer(p, index, coords, u, cb, weights, points);
+}
+
+double transferLoad(CkArrayID p, int index) {
+  return controllerProxy.ckLocalBranch()->transferLoad(p, index);
+}
+
+bool transferReady(const TransferHandle& h) {
+  return controllerProxy.ckLocalBranch()->transferReady(h);
+}
+
+void waitTransfer(const TransferHandle& h, CkCallback cb) {
+  controllerProxy.ckLocalBranch()->waitTransfer(h, cb);
+}
+
+const TransferWeights& transferWeights(CkArrayID p, int index) {
+  return controllerProxy.ckLocalBranch()->transferWeights(p, index);
+}
+
+void applySource(CkArrayID p, int index, const tk::Fields& u) {
+  controllerProxy.ckLocalBranch()->applySource(p, index, u);
+}
+
+void applyDest(CkArrayID p, int index, tk::Fields& u, CkCallback cb) {
+  controllerProxy.ckLocalBranch()->applyDest(p, index, u, cb);
 }
 
-void setDestPoints(CkArrayID p, int index, tk::UnsMesh::Coords* coords, const tk::Fields& u, CkCallback cb) {
-  controllerProxy.ckLocalBranch()->setDestPoints(p, index, coords, u, cb);
+void hashMesh(CkArrayID p, int index, const std::vector< tk::lindex >& inpoel, const tk::UnsMesh::Coords& coords, CkCallback cb) {
+  controllerProxy.ckLocalBranch()->hashMesh(p, index, inpoel, coords, cb);
+}
+
+std::uint64_t planKey(std::uint64_t key, std::uint64_t hash, int nchare)
+//! \brief Folds the content hash and number of chares of a mesh into the key
+//!   of a transfer plan, to be called for each mesh of the transfer in the
+//!   same order when saving and loading the plan, starting from key 0
+{
+  const std::array< std::uint64_t, 3 >
+    k{{ key, hash, static_cast< std::uint64_t >( nchare ) }};
+  return highwayhash::SipHash( tk::hh_key,
+    reinterpret_cast< const char* >( k.data() ), sizeof(k) );
+}
+
+void savePlan(CkArrayID p, int index, const std::string& prefix, std::uint64_t key) {
+  controllerProxy.ckLocalBranch()->savePlan(p, index, prefix, key);
+}
+
+bool loadPlan(CkArrayID p, int index, const std::string& prefix, std::uint64_t key,
+              std::size_t npoin) {
+  return controllerProxy.ckLocalBranch()->loadPlan(p, index, prefix, key, npoin);
+}
+
+void reportTimings(int iteration, const std::string& csvfile, CkCallback cb) {
+  controllerProxy.reportTimings(iteration, csvfile, cb);
+}
+
+void reportDiagnostics(int iteration, int topn, const std::string& csvfile, CkCallback cb) {
+  controllerProxy.reportDiagnostics(iteration, topn, csvfile, cb);
 }
 
 LibMain::LibMain(CkArgMsg* msg) {
+  // Parse message aggregation parameters, removing them from the arguments
+  g_aggregateBytes = 65536;
+  g_aggregateTimeout = 1.0;
+  CmiGetArgIntDesc(msg->argv, "+m2m_aggbytes", &g_aggregateBytes,
+    "Size in bytes above which aggregated transfer messages are sent (0: off)");
+  CmiGetArgDoubleDesc(msg->argv, "+m2m_aggtimeout", &g_aggregateTimeout,
+    "Time in ms after which aggregated transfer messages are sent");
+
+  // Parse the minimum number of collisions per thread processed in parallel,
+  // lists shorter than twice this are processed serially
+  g_parallelGrain = 4096;
+  CmiGetArgIntDesc(msg->argv, "+m2m_pargrain", &g_parallelGrain,
+    "Minimum number of collisions per thread processed in parallel");
+  ErrChk(g_parallelGrain > 0, "+m2m_pargrain must be positive");
   delete msg;
   controllerProxy = CProxy_Controller::ckNew();
 
+  // Initialize CkLoop used by tk::parallelFor on the worker threads of nodes,
+  // e.g., in processCollisions() and determineActualCollisions()
+  tk::initParallelFor();
+
   // TODO: Need to make sure this is actually correct
   CollideGrid3d gridMap(CkVector3d(0, 0, 0),CkVector3d(0.5, 0.5, 0.5));
   collideHandle = CollideCreate(gridMap,
@@ -61,7 +176,10 @@ LibMain::LibMain(CkArgMsg* msg) {
       //CollideSerialClient(collisionHandler, 0));
 }
 
-Controller::Controller() : current_chunk(0), num_sent(0), num_received(0), total_sent(0) {}
+Controller::Controller() : current_chunk(0), num_sent(0), num_received(0), total_sent(0),
+  m_phaseTime{{}}, m_registered(0.0), m_distributed(0.0), m_received(0.0),
+  m_reportIter(0), m_candidateHist{{}}, m_reportTopN(0),
+  m_idleFlushScheduled(false), m_timerFlushScheduled(false) {}
 
 void
 Controller::addMesh(CkArrayID p, int elem, CkCallback cb)
@@ -90,50 +208,180 @@ Controller::addMesh(CkArrayID p, int elem, CkCallback cb)
 
 void
 Controller::setMesh( CkArrayID p, MeshData d )
-//! \brief Called from Worker ctor to ensure mesh data is set on all PEs
+//! \brief Called from Worker ctor to ensure mesh data is set on all PEs, and
+//!   after a Worker migrated, keeping the mesh data if already known
 {
-  proxyMap[static_cast<std::size_t>(CkGroupID(p).idx)] = d;
+  proxyMap.emplace(static_cast<std::size_t>(CkGroupID(p).idx), d);
 }
 
 void
 Controller::setDestPoints(CkArrayID p, int index, tk::UnsMesh::Coords* coords,
-    const tk::Fields& u, CkCallback cb)
+    const tk::Fields& u, CkCallback cb, const std::vector< tk::lindex >* points)
 //! \brief Sets the designated mesh as a destination mesh and passes pointers
-//         to the destination mesh data.
+//         to the destination mesh data, and optionally to the ids of the
+//         nodes to transfer into.
 {
   proxyMap[CkGroupID(p).idx].dest = true;
+  worker(p, index)->setDestPoints(coords, u, cb, points);
+}
+
+TransferHandle
+Controller::startTransfer(CkArrayID p, int index, tk::UnsMesh::Coords* coords,
+    tk::Fields& u, CkCallback cb, bool weights,
+    const std::vector< tk::lindex >* points)
+//! \brief Sets the designated mesh as a destination mesh and starts a
+//!   split-phase transfer into it, see Worker::startTransfer().
+{
+  proxyMap[CkGroupID(p).idx].dest = true;
+  return { p, index,
+           worker(p, index)->startTransfer(coords, u, cb, weights, points) };
+}
+
+bool
+Controller::transferReady(const TransferHandle& h)
+//! \brief Queries if all data of a split-phase transfer has arrived
+{
+  return worker(h.m_array, h.m_index)->transferReady(h.m_id);
+}
+
+void
+Controller::waitTransfer(const TransferHandle& h, CkCallback cb)
+//! \brief Completes a split-phase transfer, see Worker::waitTransfer()
+{
+  worker(h.m_array, h.m_index)->waitTransfer(h.m_id, cb);
+}
+
+const TransferWeights&
+Controller::transferWeights(CkArrayID p, int index)
+//! \brief Returns the interpolation weights of the last transfer into a
+//!   destination mesh chare, see Worker::weights()
+{
+  return worker(p, index)->weights();
+}
+
+void
+Controller::applySource(CkArrayID p, int index, const tk::Fields& u)
+//! \brief Sends the source values needed to apply the interpolation weights
+//!   of the last transfer, see Worker::applySource()
+{
+  worker(p, index)->applySource(u);
+}
+
+void
+Controller::applyDest(CkArrayID p, int index, tk::Fields& u, CkCallback cb)
+//! \brief Applies the interpolation weights of the last transfer to the
+//!   source values received, see Worker::applyDest()
+{
+  worker(p, index)->applyDest(u, cb);
+}
+
+double
+Controller::transferLoad(CkArrayID p, int index)
+//! \brief Returns and resets the transfer time spent by the worker bound
+//!   to a mesh chare, see Worker::load()
+{
+  return worker(p, index)->load();
+}
+
+void
+Controller::hashMesh(CkArrayID p, int index,
+    const std::vector< tk::lindex >& inpoel,
+    const tk::UnsMesh::Coords& coords, CkCallback cb)
+//! \brief Computes the content hash of a mesh, see Worker::hashMesh()
+{
+  worker(p, index)->hashMesh(inpoel, coords, cb);
+}
+
+void
+Controller::savePlan(CkArrayID p, int index, const std::string& prefix,
+    std::uint64_t key)
+//! \brief Saves the transfer plan of a mesh chare, see Worker::savePlan()
+{
+  worker(p, index)->savePlan(prefix, key);
+}
+
+bool
+Controller::loadPlan(CkArrayID p, int index, const std::string& prefix,
+    std::uint64_t key, std::size_t npoin)
+//! \brief Loads the transfer plan of a mesh chare, see Worker::loadPlan()
+{
+  return worker(p, index)->loadPlan(prefix, key, npoin);
+}
+
+CProxy_Worker
+Controller::chunkProxy(int chunk) const
+//! \brief Returns the library-side worker array of the mesh a collision
+//!   detection chunk belongs to
+{
+  for (const auto& m : proxyMap)
+    if (chunk >= m.second.m_firstchunk &&
+        chunk < m.second.m_firstchunk + m.second.m_nchare)
+      return m.second.m_proxy;
+  Throw("Unknown collision detection chunk " + std::to_string(chunk));
+}
+
+Worker*
+Controller::worker(CkArrayID p, int index)
+//! \brief Returns the library-side worker bound to a mesh chare, which must be
+//!   local, as the worker array is bound to the mesh array
+{
   Worker* w = proxyMap[CkGroupID(p).idx].m_proxy[index].ckLocal();
   assert(w);
-  w->setDestPoints(coords, u, cb);
+  return w;
 }
 
 void
 Controller::setSourceTets(CkArrayID p, int index,
-    std::vector< std::size_t >* inpoel, tk::UnsMesh::Coords* coords,
-    const tk::Fields& u)
+    std::vector< tk::lindex >* inpoel, tk::UnsMesh::Coords* coords,
+    const tk::Fields& u, const std::vector< tk::lindex >* elems,
+    SourceField field)
 //! \brief Sets the designated mesh as a source mesh and passes pointers to the
-//         source mesh data.
+//         source mesh data, and optionally to the ids of the elements to
+//         transfer from.
 {
   proxyMap[CkGroupID(p).idx].dest = false;
-  Worker* w = proxyMap[CkGroupID(p).idx].m_proxy[index].ckLocal();
-  assert(w);
-  w->setSourceTets(inpoel, coords, u);
+  worker(p, index)->setSourceTets(inpoel, coords, u, elems, field);
+}
+
+void
+Controller::setSourceCells(CkArrayID p, int index,
+    std::vector< tk::lindex >* inpoel,
+    const std::vector< std::size_t >* cellptr, tk::UnsMesh::Coords* coords,
+    const tk::Fields& u, const std::vector< tk::lindex >* elems,
+    SourceField field)
+//! \brief Sets the designated mesh as a source mesh of mixed cell types, e.g.,
+//!   hexahedra, prisms, and pyramids, see Worker::setSourceCells().
+{
+  proxyMap[CkGroupID(p).idx].dest = false;
+  worker(p, index)->setSourceCells(inpoel, cellptr, coords, u, elems, field);
+}
+
+void
+Controller::setSourceTris(CkArrayID p, int index,
+    std::vector< tk::lindex >* triinpoel, tk::UnsMesh::Coords* coords,
+    const tk::Fields& u, tk::real tol, const std::vector< tk::lindex >* elems)
+//! \brief Sets the designated mesh as a source mesh of a surface transfer and
+//!   passes pointers to its surface triangles, see Worker::setSourceTris().
+{
+  proxyMap[CkGroupID(p).idx].dest = false;
+  worker(p, index)->setSourceTris(triinpoel, coords, u, tol, elems);
 }
 
 void
-Controller::separateCollisions(MeshDict& outgoing, bool dest, int nColl,
-                               Collision* colls) const
+separateCollisions(const MeshMap& meshes, MeshDict& outgoing, bool dest,
+                   int nColl, const Collision* colls)
 // *****************************************************************************
 //  Called on a list of potential collisions in order to separate them based on
 //  the chare they are intended for, and to convert them into the more useful
 //  DetailedCollision struct.
+//! \param[in] meshes The meshes registered with the library
 //! \param[inout] outgoing The map of lists where we will divide up collisions
 //! \param[in] dest  True if we want to separate for dest mesh, false for source
 //! \param[in] nColl Number of collisions we are separating
 //! \param[in] colls The list of collisions to separate
 // *****************************************************************************
 {
-  for (const auto& itr : proxyMap) {
+  for (const auto& itr : meshes) {
     if (itr.second.dest == dest) {
       outgoing[itr.second].resize(itr.second.m_nchare);
     }
@@ -151,14 +399,14 @@ Controller::separateCollisions(MeshDict& outgoing, bool dest, int nColl,
         if (found) CkAbort("Multiple meshes of the same type in collision\n");
         if (dest) {
           coll.dest_chunk = colls[i].A.chunk;
-          coll.dest_index = colls[i].A.number;
+          coll.dest_index = static_cast< tk::lindex >( colls[i].A.number );
           coll.source_chunk = colls[i].B.chunk;
-          coll.source_index = colls[i].B.number;
+          coll.source_index = static_cast< tk::lindex >( colls[i].B.number );
         } else {
           coll.dest_chunk = colls[i].B.chunk;
-          coll.dest_index = colls[i].B.number;
+          coll.dest_index = static_cast< tk::lindex >( colls[i].B.number );
           coll.source_chunk = colls[i].A.chunk;
-          coll.source_index = colls[i].A.number;
+          coll.source_index = static_cast< tk::lindex >( colls[i].A.number );
         }
         itr.second[aidx].push_back(coll);
         found = true;
@@ -168,14 +416,14 @@ Controller::separateCollisions(MeshDict& outgoing, bool dest, int nColl,
         if (found) CkAbort("Multiple meshes of the same type in collision\n");
         if (dest) {
           coll.dest_chunk = colls[i].B.chunk;
-          coll.dest_index = colls[i].B.number;
+          coll.dest_index = static_cast< tk::lindex >( colls[i].B.number );
           coll.source_chunk = colls[i].A.chunk;
-          coll.source_index = colls[i].A.number;
+          coll.source_index = static_cast< tk::lindex >( colls[i].A.number );
         } else {
           coll.dest_chunk = colls[i].A.chunk;
-          coll.dest_index = colls[i].A.number;
+          coll.dest_index = static_cast< tk::lindex >( colls[i].A.number );
           coll.source_chunk = colls[i].B.chunk;
-          coll.source_index = colls[i].B.number;
+          coll.source_index = static_cast< tk::lindex >( colls[i].B.number );
         }
         itr.second[bidx].push_back(coll);
         found = true;
@@ -186,19 +434,20 @@ Controller::separateCollisions(MeshDict& outgoing, bool dest, int nColl,
 }
 
 void
-Controller::separateCollisions(MeshDict& outgoing, bool dest, int nColl,
-                               DetailedCollision* colls) const
+separateCollisions(const MeshMap& meshes, MeshDict& outgoing, bool dest,
+                   int nColl, const DetailedCollision* colls)
 // *****************************************************************************
 //  Called on a list of potential collisions in order to separate them based on
 //  the chare they are intended for. This version of the function is for
 //  collisions which have already been converted to DetailedCollision.
+//! \param[in] meshes The meshes registered with the library
 //! \param[inout] outgoing The map of lists where we will divide up collisions
 //! \param[in] dest  True if we want to separate for dest mesh, false for source
 //! \param[in] nColl Number of collisions we are separating
 //! \param[in] colls The list of collisions to separate
 // *****************************************************************************
 {
-  for (const auto& itr : proxyMap) {
+  for (const auto& itr : meshes) {
     if (itr.second.dest == dest) {
       outgoing[itr.second].resize(itr.second.m_nchare);
     }
@@ -230,8 +479,14 @@ Controller::distributeCollisions(int nColl, Collision* colls)
 {
   CkPrintf("[%i]: Collisions found: %i\n", CkMyPe(), nColl);
 
+  auto t0 = CkWallTimer();
+  completed();
+  if (m_registered > 0.0) addTime(Phase::COLLIDE, t0 - m_registered);
+  m_registered = 0.0;
+
   MeshDict outgoing;
   separateCollisions(outgoing, true, nColl, colls);
+  addTime(Phase::SEPARATE, CkWallTimer() - t0);
 
   // Send out each list to the destination chares for further processing
   for (auto& itr : outgoing) {
@@ -245,6 +500,7 @@ Controller::distributeCollisions(int nColl, Collision* colls)
       }
     }
   }
+  m_distributed = CkWallTimer();
   // TODO: Count is not getting reset between iterations
   CkPrintf("[%i]: Sent %i\n", CkMyPe(), num_sent);
   contribute(sizeof(int), &num_sent, CkReduction::sum_int, CkCallback(CkReductionTarget(Controller,allSent), thisProxy));
@@ -287,6 +543,413 @@ Controller::checkDone(int total) {
   // or use some other method of CD to check when the transfer is complete.
 }
 
+void
+Controller::completed()
+// *****************************************************************************
+//  Account for the completion phase of the last transfer on this PE, i.e., the
+//  time from distributing the collisions to receiving the last solution data
+// *****************************************************************************
+{
+  if (m_distributed > 0.0 && m_received > m_distributed)
+    addTime(Phase::COMPLETE, m_received - m_distributed);
+  m_distributed = m_received = 0.0;
+}
+
+void
+Controller::reportTimings(int it, const std::string& csvfile, CkCallback cb)
+// *****************************************************************************
+//  Reduce the per-phase transfer timings across all PEs and report them
+//! \param[in] it Iteration to tag the report with
+//! \param[in] csvfile File to append the report to in CSV format (none if
+//!   empty)
+//! \param[in] cb Callback to call when the report is done
+//! \details The timings accumulated on each PE since the last report are
+//!   reduced to their minimum, maximum, and sum across PEs, and reset. The
+//!   report is output to screen as a single line of JSON on PE 0.
+// *****************************************************************************
+{
+  if (CkMyPe() == 0) {
+    m_reportIter = it;
+    m_reportFile = csvfile;
+    m_reportCb = cb;
+  }
+
+  completed();
+  auto t = m_phaseTime;
+  m_phaseTime.fill(0.0);
+
+  CkReduction::tupleElement tuple[] = {
+    CkReduction::tupleElement(sizeof(double)*NUM_PHASES, t.data(),
+                              CkReduction::min_double),
+    CkReduction::tupleElement(sizeof(double)*NUM_PHASES, t.data(),
+                              CkReduction::max_double),
+    CkReduction::tupleElement(sizeof(double)*NUM_PHASES, t.data(),
+                              CkReduction::sum_double) };
+  auto msg = CkReductionMsg::buildFromTuple(tuple, 3);
+  msg->setCallback(CkCallback(CkIndex_Controller::timingsReduced(nullptr),
+                              thisProxy[0]));
+  contribute(msg);
+}
+
+void
+Controller::timingsReduced(CkReductionMsg* msg)
+// *****************************************************************************
+//  Output per-phase transfer timings reduced across all PEs
+//! \param[in] msg Reduction message with the min, max, and sum of the per-PE
+//!   timings of all phases
+// *****************************************************************************
+{
+  CkReduction::tupleElement* results = nullptr;
+  int num = 0;
+  msg->toTuple(&results, &num);
+  Assert(num == 3, "Timing reduction expected a tuple of 3");
+  const auto mins = static_cast< const double* >(results[0].data);
+  const auto maxs = static_cast< const double* >(results[1].data);
+  const auto sums = static_cast< const double* >(results[2].data);
+  const auto npe = static_cast< double >(CkNumPes());
+
+  // Output timings as a single line of JSON
+  std::stringstream json;
+  json << "{\"iteration\":" << m_reportIter << ",\"npes\":" << CkNumPes()
+       << ",\"phases\":{";
+  for (std::size_t p=0; p<NUM_PHASES; ++p)
+    json << (p ? "," : "") << '"' << PHASE_NAMES[p] << "\":{\"min\":"
+         << mins[p] << ",\"max\":" << maxs[p] << ",\"avg\":" << sums[p]/npe
+         << '}';
+  json << "}}";
+  CkPrintf("ExaM2M> Transfer timings: %s\n", json.str().c_str());
+
+  // Append timings to CSV file
+  if (!m_reportFile.empty()) {
+    std::ofstream csv(m_reportFile, std::ios::app);
+    ErrChk(csv.good(), "Failed to open file " + m_reportFile);
+    if (csv.tellp() == 0) csv << "iteration,npes,phase,min,max,avg\n";
+    // Fixed microsecond resolution keeps the file simple to parse, e.g., by
+    // the performance regression tests, see cmake/test_runner.cmake
+    csv << std::fixed << std::setprecision(6);
+    for (std::size_t p=0; p<NUM_PHASES; ++p)
+      csv << m_reportIter << ',' << CkNumPes() << ',' << PHASE_NAMES[p] << ','
+          << mins[p] << ',' << maxs[p] << ',' << sums[p]/npe << '\n';
+  }
+
+  delete [] results;
+  delete msg;
+  m_reportCb.send();
+}
+
+ChareCounters&
+Controller::counters(int chunk)
+// *****************************************************************************
+//  Access diagnostics counters of a mesh chare, creating them if needed
+//! \param[in] chunk Collision detection chunk id of the mesh chare
+//! \return Reference to the counters of the mesh chare on this PE
+// *****************************************************************************
+{
+  auto it = m_counters.find(chunk);
+  if (it == end(m_counters))
+    it = m_counters.emplace(chunk, ChareCounters{chunk,0,0,0,0}).first;
+  return it->second;
+}
+
+void
+Controller::sourceCounts(int chunk, std::size_t candidates, std::size_t hits)
+// *****************************************************************************
+//  Count broad-phase candidates tested and hits of a source chare
+//! \param[in] chunk Collision detection chunk id of the source chare
+//! \param[in] candidates Number of candidates tested by intet
+//! \param[in] hits Number of candidates found in a source tet
+// *****************************************************************************
+{
+  auto& c = counters(chunk);
+  c.candidates += candidates;
+  c.hits += hits;
+}
+
+void
+Controller::destCounts(int chunk, const std::vector< uint32_t >& candidates,
+                       const std::vector< char >& found)
+// *****************************************************************************
+//  Count points, misses, and candidates per point of a destination chare
+//! \param[in] chunk Collision detection chunk id of the destination chare
+//! \param[in] candidates Number of broad-phase candidates of each point
+//! \param[in] found Nonzero for each point that received a value
+// *****************************************************************************
+{
+  auto& c = counters(chunk);
+  c.points += found.size();
+  c.misses += static_cast< uint64_t >(
+                std::count(begin(found), end(found), 0) );
+  for (auto n : candidates) {
+    std::size_t b = 0;
+    while (n) { ++b; n >>= 1; }
+    ++m_candidateHist[ std::min(b, NUM_CANDIDATE_BINS-1) ];
+  }
+}
+
+void
+Controller::reportDiagnostics(int it, int topn, const std::string& csvfile,
+                              CkCallback cb)
+// *****************************************************************************
+//  Reduce the transfer diagnostics counters across all PEs and report them
+//! \param[in] it Iteration to tag the report with
+//! \param[in] topn Number of hottest source chares to list
+//! \param[in] csvfile File to append the per-chare counters to in CSV format
+//!   (none if empty)
+//! \param[in] cb Callback to call when the report is done
+//! \details The histogram is summed across PEs, while the per-chare counters
+//!   are concatenated and merged on PE 0, since the chares of a mesh may have
+//!   contributed from different PEs. Counters are reset after contributing.
+// *****************************************************************************
+{
+  if (CkMyPe() == 0) {
+    m_reportIter = it;
+    m_reportTopN = topn;
+    m_reportFile = csvfile;
+    m_reportCb = cb;
+  }
+
+  std::vector< ChareCounters > chares;
+  for (const auto& [chunk,c] : m_counters) chares.push_back(c);
+  auto hist = m_candidateHist;
+  m_counters.clear();
+  m_candidateHist.fill(0);
+
+  CkReduction::tupleElement tuple[] = {
+    CkReduction::tupleElement(sizeof(uint64_t)*NUM_CANDIDATE_BINS, hist.data(),
+                              CkReduction::sum_ulong_long),
+    CkReduction::tupleElement(sizeof(ChareCounters)*chares.size(),
+                              chares.data(), CkReduction::concat) };
+  auto msg = CkReductionMsg::buildFromTuple(tuple, 2);
+  msg->setCallback(CkCallback(CkIndex_Controller::diagnosticsReduced(nullptr),
+                              thisProxy[0]));
+  contribute(msg);
+}
+
+void
+Controller::diagnosticsReduced(CkReductionMsg* msg)
+// *****************************************************************************
+//  Output transfer diagnostics counters reduced across all PEs
+//! \param[in] msg Reduction message with the candidate histogram and the
+//!   per-chare counters
+// *****************************************************************************
+{
+  CkReduction::tupleElement* results = nullptr;
+  int num = 0;
+  msg->toTuple(&results, &num);
+  Assert(num == 2, "Diagnostics reduction expected a tuple of 2");
+  const auto hist = static_cast< const uint64_t* >(results[0].data);
+  const auto rec = static_cast< const ChareCounters* >(results[1].data);
+  const auto nrec = static_cast< std::size_t >(results[1].dataSize) /
+                    sizeof(ChareCounters);
+
+  // Merge counters of the same chare contributed from different PEs
+  std::map< int, ChareCounters > chares;
+  ChareCounters total{-1,0,0,0,0};
+  for (std::size_t i=0; i<nrec; ++i) {
+    auto& c = chares.emplace(rec[i].chunk,
+                             ChareCounters{rec[i].chunk,0,0,0,0}).first->second;
+    c.candidates += rec[i].candidates;  total.candidates += rec[i].candidates;
+    c.hits += rec[i].hits;              total.hits += rec[i].hits;
+    c.points += rec[i].points;          total.points += rec[i].points;
+    c.misses += rec[i].misses;          total.misses += rec[i].misses;
+  }
+
+  // Find the hottest source chares, i.e., those testing the most candidates
+  std::vector< ChareCounters > hot;
+  for (const auto& [chunk,c] : chares) if (c.candidates) hot.push_back(c);
+  auto ntop = std::min(hot.size(), static_cast< std::size_t >(m_reportTopN));
+  std::partial_sort(begin(hot), begin(hot) + static_cast< long >(ntop),
+    end(hot), [](const ChareCounters& a, const ChareCounters& b){
+      return a.candidates > b.candidates; });
+  hot.resize(ntop);
+
+  // Output global counters, histogram, and hottest chares as a line of JSON
+  std::stringstream json;
+  json << "{\"iteration\":" << m_reportIter
+       << ",\"candidates\":" << total.candidates
+       << ",\"hits\":" << total.hits
+       << ",\"hitratio\":" << (total.candidates ?
+            static_cast< double >(total.hits) /
+            static_cast< double >(total.candidates) : 0.0)
+       << ",\"points\":" << total.points
+       << ",\"misses\":" << total.misses
+       << ",\"candidates_per_point_log2_histogram\":[";
+  for (std::size_t b=0; b<NUM_CANDIDATE_BINS; ++b)
+    json << (b ? "," : "") << hist[b];
+  json << "],\"hottest_source_chunks\":[";
+  for (std::size_t i=0; i<hot.size(); ++i)
+    json << (i ? "," : "") << "{\"chunk\":" << hot[i].chunk
+         << ",\"candidates\":" << hot[i].candidates
+         << ",\"hits\":" << hot[i].hits << '}';
+  json << "]}";
+  CkPrintf("ExaM2M> Transfer diagnostics: %s\n", json.str().c_str());
+
+  // Append per-chare counters to CSV file
+  if (!m_reportFile.empty()) {
+    std::ofstream csv(m_reportFile, std::ios::app);
+    ErrChk(csv.good(), "Failed to open file " + m_reportFile);
+    if (csv.tellp() == 0)
+      csv << "iteration,chunk,candidates,hits,points,misses\n";
+    for (const auto& [chunk,c] : chares)
+      csv << m_reportIter << ',' << chunk << ',' << c.candidates << ','
+          << c.hits << ',' << c.points << ',' << c.misses << '\n';
+  }
+
+  delete [] results;
+  delete msg;
+  m_reportCb.send();
+}
+
+void
+Controller::sendCandidates(CandidateBatch&& b)
+// *****************************************************************************
+//  Send potential collisions of a dest mesh chare to a source mesh chare
+//! \param[in] b Potential collisions to be checked by the source chare and
+//!   the dest chare it replies to
+//! \details Unless aggregation is turned off, the collisions are buffered with
+//!   other messages to mesh chares on the node the source chare is on, and
+//!   sent to that node in a single message later.
+// *****************************************************************************
+{
+  if (g_aggregateBytes <= 0) {
+    b.m_source[b.m_sourceIndex].determineActualCollisions(b.m_dest,
+      b.m_destIndex, b.m_weights, static_cast<int>(b.m_colls.size()),
+      b.m_colls.data());
+    return;
+  }
+
+  auto pe = b.m_source.ckLocalBranch()->lastKnown(
+              CkArrayIndex1D(b.m_sourceIndex));
+  auto node = CkNodeOf(pe);
+  auto bytes = sizeof(CandidateBatch) +
+               b.m_colls.size()*sizeof(DetailedCollision);
+  m_aggregate[node].m_candidates.push_back(std::move(b));
+  aggregated(node, bytes);
+}
+
+void
+Controller::sendSolution(SolutionBatch&& b)
+// *****************************************************************************
+//  Send solution data of a source mesh chare to a dest mesh chare
+//! \param[in] b Solution data, and interpolation weights if requested, at
+//!   points of the dest chare
+//! \details Unless aggregation is turned off, the solution data is buffered
+//!   with other messages to mesh chares on the node the dest chare is on, and
+//!   sent to that node in a single message later.
+// *****************************************************************************
+{
+  if (g_aggregateBytes <= 0) {
+    b.m_dest[b.m_destIndex].transferSolution(b.m_sourceChunk, b.m_sourceIndex,
+      b.m_index.size(), b.m_index.data(), b.m_soln.data(),
+      b.m_dist.size(), b.m_dist.data(),
+      b.m_node.size(), b.m_node.data(), b.m_pos.data(), b.m_weight.data());
+    return;
+  }
+
+  auto pe = b.m_dest.ckLocalBranch()->lastKnown(CkArrayIndex1D(b.m_destIndex));
+  auto node = CkNodeOf(pe);
+  auto bytes = sizeof(SolutionBatch) +
+               b.m_index.size()*(sizeof(tk::lindex) + sizeof(tk::real)) +
+               b.m_dist.size()*sizeof(tk::real) +
+               b.m_node.size()*(2*sizeof(tk::lindex) + sizeof(tk::real));
+  m_aggregate[node].m_solutions.push_back(std::move(b));
+  aggregated(node, bytes);
+}
+
+void
+Controller::aggregated(int node, std::size_t bytes)
+// *****************************************************************************
+//  Add the size of a batch to an aggregation buffer and flush it if full
+//! \param[in] node Node the aggregation buffer is sent to
+//! \param[in] bytes Approximate size of the batch added in bytes
+//! \details If the buffer is not full, flushing all buffers is scheduled for
+//!   when this PE becomes idle or the flush timeout expires, whichever comes
+//!   first, so messages are never held back while there is nothing else to do.
+//!   The idle callback and the timer are tracked separately, since the one
+//!   not firing first stays pending, so at most one of each is registered.
+// *****************************************************************************
+{
+  auto& buf = m_aggregate[node];
+  buf.m_bytes += bytes;
+  if (buf.m_bytes >= static_cast< std::size_t >(g_aggregateBytes)) {
+    flush(node, buf);
+    return;
+  }
+  if (!m_idleFlushScheduled) {
+    m_idleFlushScheduled = true;
+    CcdCallOnCondition(CcdPROCESSOR_BEGIN_IDLE, idleFlushHandler, this);
+  }
+  if (!m_timerFlushScheduled) {
+    m_timerFlushScheduled = true;
+    CcdCallFnAfter(timerFlushHandler, this, g_aggregateTimeout);
+  }
+}
+
+void
+Controller::flush(int node, AggregateBuffer& buf)
+// *****************************************************************************
+//  Send an aggregation buffer to a node
+//! \param[in] node Node to send the buffer to
+//! \param[in,out] buf Aggregation buffer to send, emptied
+// *****************************************************************************
+{
+  if (buf.m_candidates.empty() && buf.m_solutions.empty()) return;
+  thisProxy[CkNodeFirst(node)].deliver(buf);
+  buf.m_candidates.clear();
+  buf.m_solutions.clear();
+  buf.m_bytes = 0;
+}
+
+void
+Controller::flushAggregates(bool idle)
+// *****************************************************************************
+//  Send all aggregation buffers
+//! \param[in] idle True if called as this PE became idle, false if called as
+//!   the flush timeout expired
+//! \details Called by the Charm++ scheduler when this PE becomes idle or the
+//!   flush timeout expires.
+// *****************************************************************************
+{
+  if (idle)
+    m_idleFlushScheduled = false;
+  else
+    m_timerFlushScheduled = false;
+  for (auto& [node,buf] : m_aggregate) flush(node, buf);
+}
+
+void
+Controller::deliver(AggregateBuffer buf)
+// *****************************************************************************
+//  Deliver aggregated messages to mesh chares on this node
+//! \param[in] buf Aggregated messages
+//! \details Mesh chares on this PE are called directly, while the messages to
+//!   chares on other PEs of the node (or that have migrated) are forwarded.
+// *****************************************************************************
+{
+  for (auto& b : buf.m_candidates) {
+    auto w = b.m_source[b.m_sourceIndex].ckLocal();
+    if (w)
+      w->determineActualCollisions(b.m_dest, b.m_destIndex, b.m_weights,
+        static_cast<int>(b.m_colls.size()), b.m_colls.data());
+    else
+      b.m_source[b.m_sourceIndex].determineActualCollisions(b.m_dest,
+        b.m_destIndex, b.m_weights, static_cast<int>(b.m_colls.size()),
+        b.m_colls.data());
+  }
+  for (auto& b : buf.m_solutions) {
+    auto w = b.m_dest[b.m_destIndex].ckLocal();
+    if (w)
+      w->transferSolution(b.m_sourceChunk, b.m_sourceIndex, b.m_index.size(),
+        b.m_index.data(), b.m_soln.data(), b.m_dist.size(), b.m_dist.data(),
+        b.m_node.size(), b.m_node.data(), b.m_pos.data(), b.m_weight.data());
+    else
+      b.m_dest[b.m_destIndex].transferSolution(b.m_sourceChunk,
+        b.m_sourceIndex, b.m_index.size(), b.m_index.data(), b.m_soln.data(),
+        b.m_dist.size(), b.m_dist.data(), b.m_node.size(), b.m_node.data(),
+        b.m_pos.data(), b.m_weight.data());
+  }
+}
+
 #if defined(__clang__)
   #pragma clang diagnostic pop
 #endif
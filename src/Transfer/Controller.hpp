@@ -2,17 +2,123 @@
 #define Controller_h
 
 // Controller for the library
+//
+// Applications using the library link the Charm++ modules collidecharm and
+// CkLoop, see EXTRA_LINK_ARGS in src/CMakeLists.txt. CkLoop is initialized by
+// the library's main chare, LibMain.
 
 #include "NoWarning/controller.decl.h"
 
+#include <array>
+#include <map>
+#include <string>
+#include <cstdint>
+
 #include "collidecharm.h"
 #include "Fields.hpp"
+#include "PUPUtil.hpp"
 
 namespace exam2m {
 
+//! Transfer phases timed on each PE
+enum class Phase : std::size_t {
+  REGISTER = 0,   //!< Source/destination box registration
+  COLLIDE,        //!< Collision detection library (broad phase)
+  SEPARATE,       //!< Separating collisions by mesh chare
+  PROCESS,        //!< Filling in destination points (processCollisions)
+  NARROW,         //!< Point-in-tet tests and interpolation (intet)
+  COMPLETE        //!< Returning solution data and completion detection
+};
+//! Number of timed transfer phases
+constexpr std::size_t NUM_PHASES = 6;
+//! Names of timed transfer phases used in reports
+const std::array< const char*, NUM_PHASES > PHASE_NAMES {{
+  "register", "collide", "separate", "process", "narrow", "complete" }};
+
+//! Number of bins of the histogram of broad-phase candidates per dest point
+//! \details Bin 0 counts points without candidates, bin b > 0 counts points
+//!   with [2^(b-1), 2^b) candidates, the last bin also counts all above.
+constexpr std::size_t NUM_CANDIDATE_BINS = 16;
+
+//! Transfer diagnostics counters of a mesh chare
+struct ChareCounters {
+  int chunk;                //!< Collision detection chunk id of the chare
+  uint64_t candidates;      //!< Broad-phase candidates tested as source
+  uint64_t hits;            //!< Candidates found in a source tet
+  uint64_t points;          //!< Points of the chare as destination
+  uint64_t misses;          //!< Destination points that received no value
+};
+
+//! Handle of a split-phase transfer into a destination mesh chare
+//! \details Returned by startTransfer() and passed to transferReady() and
+//!   waitTransfer() on the same destination mesh chare.
+struct TransferHandle {
+  CkArrayID m_array;        //!< Destination mesh chare array
+  int m_index;              //!< Destination mesh chare index
+  int m_id;                 //!< Sequence number of transfer on the chare
+  void pup(PUP::er& p) {
+    p | m_array;
+    p | m_index;
+    p | m_id;
+  }
+};
+
+//! Location of the source solution values and how they are interpolated
+//! \details Cell fields let finite-volume codes transfer their cell averages
+//!   directly, without averaging them to the nodes and reconstructing them
+//!   afterwards. The destination is unaffected: its points, e.g., the
+//!   centroids of its cells, receive values either way.
+enum class SourceField : int {
+  NODE = 0,     //!< In mesh nodes, interpolated by the cell shapefunctions
+  CELL,         //!< In mesh cells, constant in each cell
+  CELL_LINEAR   //!< In mesh cells with their gradient, linear in each cell
+};
+
+//! Interpolation weights of the last transfer into a destination mesh chare
+//! \details Sparse matrix in compressed sparse row (CSR) form with a row for
+//!   each point of the chare: the value transferred to point p is the sum of
+//!   m_weight[j] times the source solution at node m_node[j] of source mesh
+//!   chare m_chare[j] over j in [ m_rowptr[p], m_rowptr[p+1] ). Rows of points
+//!   that received no value are empty, all others have the same number of
+//!   entries, the shapefunctions of the source cell the point was found in:
+//!   four for tetrahedra, and up to eight if the source cells are of mixed
+//!   type, those of cells with fewer nodes padded with zero weights. Surface
+//!   transfers yield the shapefunctions of the source triangle the point was
+//!   projected to, padded with a zero weight. Cell fields (SourceField::CELL)
+//!   yield a single weight of one, m_node holding the id of the source cell
+//!   instead of a node, padded with zero weights.
+struct TransferWeights {
+  std::vector< std::size_t > m_rowptr;  //!< Row offsets, one more than points
+  std::vector< int > m_chare;           //!< Source mesh chare of nonzeros
+  std::vector< tk::lindex > m_node;     //!< Source mesh chare local node ids
+  std::vector< tk::real > m_weight;     //!< Interpolation weights
+  void pup(PUP::er& p) {
+    p | m_rowptr;
+    p | m_chare;
+    p | m_node;
+    p | m_weight;
+  }
+};
+
 void addMesh(CkArrayID p, int elem, CkCallback cb);
-void setSourceTets(CkArrayID p, int index, std::vector< std::size_t >* inpoel, tk::UnsMesh::Coords* coords, const tk::Fields& u);
-void setDestPoints(CkArrayID p, int index, tk::UnsMesh::Coords* coords, const tk::Fields& u, CkCallback cb);
+void setSourceTets(CkArrayID p, int index, std::vector< tk::lindex >* inpoel, tk::UnsMesh::Coords* coords, const tk::Fields& u, const std::vector< tk::lindex >* elems = nullptr, SourceField field = SourceField::NODE);
+void setSourceCells(CkArrayID p, int index, std::vector< tk::lindex >* inpoel, const std::vector< std::size_t >* cellptr, tk::UnsMesh::Coords* coords, const tk::Fields& u, const std::vector< tk::lindex >* elems = nullptr, SourceField field = SourceField::NODE);
+void setSourceTris(CkArrayID p, int index, std::vector< tk::lindex >* triinpoel, tk::UnsMesh::Coords* coords, const tk::Fields& u, tk::real tol, const std::vector< tk::lindex >* elems = nullptr);
+void setDestPoints(CkArrayID p, int index, tk::UnsMesh::Coords* coords, const tk::Fields& u, CkCallback cb, const std::vector< tk::lindex >* points = nullptr);
+TransferHandle startTransfer(CkArrayID p, int index, tk::UnsMesh::Coords* coords, tk::Fields& u, CkCallback cb, bool weights = false, const std::vector< tk::lindex >* points = nullptr);
+bool transferReady(const TransferHandle& h);
+void waitTransfer(const TransferHandle& h, CkCallback cb);
+const TransferWeights& transferWeights(CkArrayID p, int index);
+void applySource(CkArrayID p, int index, const tk::Fields& u);
+void applyDest(CkArrayID p, int index, tk::Fields& u, CkCallback cb);
+double transferLoad(CkArrayID p, int index);
+void hashMesh(CkArrayID p, int index, const std::vector< tk::lindex >& inpoel, const tk::UnsMesh::Coords& coords, CkCallback cb);
+std::uint64_t planKey(std::uint64_t key, std::uint64_t hash, int nchare);
+void savePlan(CkArrayID p, int index, const std::string& prefix, std::uint64_t key);
+bool loadPlan(CkArrayID p, int index, const std::string& prefix, std::uint64_t key,
+              std::size_t npoin);
+void reportTimings(int iteration, const std::string& csvfile, CkCallback cb);
+void reportDiagnostics(int iteration, int topn, const std::string& csvfile, CkCallback cb);
 
 class LibMain : public CBase_LibMain {
 public:
@@ -35,16 +141,73 @@ class MeshData {
 
 class DetailedCollision {
 public:
-  std::size_t source_chunk, dest_chunk;
-  std::size_t source_index, dest_index;
   // TODO: Can this just be a more generic type like std::array
   CkVector3d point;
+  int source_chunk, dest_chunk;
+  tk::lindex source_index, dest_index;
   void pup(PUP::er& p) {
     p | source_chunk; p | source_index;
     p | dest_chunk; p | dest_index;
     p | point;
   }
 };
+
+//! Potential collisions sent by a dest mesh chare to a source mesh chare
+struct CandidateBatch {
+  CProxy_Worker m_source;       //!< Source mesh chare array
+  int m_sourceIndex;            //!< Source mesh chare index
+  CProxy_Worker m_dest;         //!< Dest mesh chare array to reply to
+  int m_destIndex;              //!< Dest mesh chare index to reply to
+  bool m_weights;               //!< True to reply with interpolation weights
+  std::vector< DetailedCollision > m_colls;     //!< Potential collisions
+  void pup(PUP::er& p) {
+    p | m_source; p | m_sourceIndex;
+    p | m_dest; p | m_destIndex;
+    p | m_weights;
+    p | m_colls;
+  }
+};
+
+//! Solution data sent by a source mesh chare to a dest mesh chare
+struct SolutionBatch {
+  CProxy_Worker m_dest;         //!< Dest mesh chare array
+  int m_destIndex;              //!< Dest mesh chare index
+  int m_sourceChunk;            //!< Source mesh chare chunk id
+  int m_sourceIndex;            //!< Source mesh chare index
+  std::vector< tk::lindex > m_index;            //!< Dest mesh point indices
+  std::vector< tk::real > m_soln;               //!< Solution at dest points
+  //! Distance of the dest points from the source surface, empty unless the
+  //! source is a surface
+  std::vector< tk::real > m_dist;
+  //! Source nodes of the cells the dest points are in, the same number per
+  //! point, empty unless interpolation weights were requested
+  std::vector< tk::lindex > m_node;
+  //! Position of the source node values sent when applying weights
+  std::vector< tk::lindex > m_pos;
+  std::vector< tk::real > m_weight;             //!< Interpolation weights
+  void pup(PUP::er& p) {
+    p | m_dest; p | m_destIndex;
+    p | m_sourceChunk; p | m_sourceIndex;
+    p | m_index;
+    p | m_soln;
+    p | m_dist;
+    p | m_node;
+    p | m_pos;
+    p | m_weight;
+  }
+};
+
+//! Messages to mesh chares on a node aggregated into a single message
+struct AggregateBuffer {
+  std::vector< CandidateBatch > m_candidates;   //!< Potential collisions
+  std::vector< SolutionBatch > m_solutions;     //!< Solution data
+  std::size_t m_bytes = 0;                      //!< Approximate size in bytes
+  void pup(PUP::er& p) {
+    p | m_candidates;
+    p | m_solutions;
+    p | m_bytes;
+  }
+};
 }
 
 namespace std {
@@ -65,13 +228,68 @@ namespace std {
 
 namespace exam2m {
 
+//! Meshes registered with the library, keyed by their chare array group index
+using MeshMap = std::unordered_map<CmiUInt8, MeshData>;
+//! Lists of collisions for each chare of each mesh
+using MeshDict = std::unordered_map<MeshData, std::vector<std::vector<DetailedCollision>>>;
+
+//! Separate potential collisions by the mesh chare they belong to
+void separateCollisions(const MeshMap& meshes, MeshDict& outgoing, bool dest,
+                        int nColl, const Collision* colls);
+//! Separate detailed collisions by the mesh chare they belong to
+void separateCollisions(const MeshMap& meshes, MeshDict& outgoing, bool dest,
+                        int nColl, const DetailedCollision* colls);
+
 class Controller : public CBase_Controller {
   private:
-    std::unordered_map<CmiUInt8, MeshData> proxyMap;
+    MeshMap proxyMap;
     int current_chunk;
 
     int num_sent, num_received, total_sent, total_received;
 
+    //! Wall-clock time spent in each transfer phase on this PE since last report
+    std::array< double, NUM_PHASES > m_phaseTime;
+    //! Wall-clock time of the last box registration on this PE
+    double m_registered;
+    //! Wall-clock time the collisions were distributed on this PE
+    double m_distributed;
+    //! Wall-clock time the last solution data was received on this PE
+    double m_received;
+    //! Iteration of the timing report in progress
+    int m_reportIter;
+    //! File to append the timing report in progress to in CSV format
+    std::string m_reportFile;
+    //! Callback to call when the timing report in progress is done
+    CkCallback m_reportCb;
+
+    //! Account for the completion phase of the last transfer
+    void completed();
+
+    //! Transfer diagnostics counters of mesh chares on this PE since last report
+    std::map< int, ChareCounters > m_counters;
+    //! Histogram of candidates per dest point on this PE since last report
+    std::array< uint64_t, NUM_CANDIDATE_BINS > m_candidateHist;
+    //! Number of hottest source chares to list in the diagnostics report
+    int m_reportTopN;
+
+    //! Access diagnostics counters of a mesh chare, creating them if needed
+    ChareCounters& counters(int chunk);
+
+    //! Access the local library-side worker bound to a mesh chare
+    Worker* worker(CkArrayID p, int index);
+
+    //! Aggregation buffers of messages to mesh chares, keyed by target node
+    std::map< int, AggregateBuffer > m_aggregate;
+    //! True if flushing the aggregation buffers is scheduled for when idle
+    bool m_idleFlushScheduled;
+    //! True if flushing the aggregation buffers is scheduled after a timeout
+    bool m_timerFlushScheduled;
+
+    //! Add the size of a batch to an aggregation buffer and flush it if full
+    void aggregated(int node, std::size_t bytes);
+    //! Send an aggregation buffer to a node
+    void flush(int node, AggregateBuffer& buf);
+
   public:
     Controller();
     #if defined(__clang__)
@@ -83,28 +301,95 @@ class Controller : public CBase_Controller {
       #pragma clang diagnostic pop
     #endif
 
-    using MeshDict = std::unordered_map<MeshData, std::vector<std::vector<DetailedCollision>>>;
+    using MeshDict = exam2m::MeshDict;
 
     void addMesh(CkArrayID p, int elem, CkCallback cb);
     void setMesh(CkArrayID p, MeshData d);
-    void setSourceTets(CkArrayID p, int index, std::vector< std::size_t >* inpoel,
-                       tk::UnsMesh::Coords* coords, const tk::Fields& u);
+    void setSourceTets(CkArrayID p, int index, std::vector< tk::lindex >* inpoel,
+                       tk::UnsMesh::Coords* coords, const tk::Fields& u,
+                       const std::vector< tk::lindex >* elems,
+                       SourceField field);
+    void setSourceCells(CkArrayID p, int index,
+                        std::vector< tk::lindex >* inpoel,
+                        const std::vector< std::size_t >* cellptr,
+                        tk::UnsMesh::Coords* coords, const tk::Fields& u,
+                        const std::vector< tk::lindex >* elems,
+                        SourceField field);
+    void setSourceTris(CkArrayID p, int index,
+                       std::vector< tk::lindex >* triinpoel,
+                       tk::UnsMesh::Coords* coords, const tk::Fields& u,
+                       tk::real tol, const std::vector< tk::lindex >* elems);
     void setDestPoints(CkArrayID p, int index, tk::UnsMesh::Coords* coords,
-                       const tk::Fields& u, CkCallback cb);
+                       const tk::Fields& u, CkCallback cb,
+                       const std::vector< tk::lindex >* points);
+    TransferHandle startTransfer(CkArrayID p, int index,
+                                 tk::UnsMesh::Coords* coords, tk::Fields& u,
+                                 CkCallback cb, bool weights,
+                                 const std::vector< tk::lindex >* points);
+    bool transferReady(const TransferHandle& h);
+    void waitTransfer(const TransferHandle& h, CkCallback cb);
+    const TransferWeights& transferWeights(CkArrayID p, int index);
+    void applySource(CkArrayID p, int index, const tk::Fields& u);
+    void applyDest(CkArrayID p, int index, tk::Fields& u, CkCallback cb);
+    double transferLoad(CkArrayID p, int index);
+    void hashMesh(CkArrayID p, int index,
+                  const std::vector< tk::lindex >& inpoel,
+                  const tk::UnsMesh::Coords& coords, CkCallback cb);
+    void savePlan(CkArrayID p, int index, const std::string& prefix,
+                  std::uint64_t key);
+    bool loadPlan(CkArrayID p, int index, const std::string& prefix,
+                  std::uint64_t key, std::size_t npoin);
+    //! Return the library-side worker array holding a collision detection chunk
+    CProxy_Worker chunkProxy(int chunk) const;
 
     void distributeCollisions(CkDataMsg* msg) {
       distributeCollisions(msg->getSize()/sizeof(Collision), (Collision*)msg->getData());
     }
     void distributeCollisions(int nColl, Collision* colls);
     void separateCollisions(MeshDict& outgoing, bool dest, int nColl,
-                            Collision* colls) const;
+                            Collision* colls) const {
+      exam2m::separateCollisions(proxyMap, outgoing, dest, nColl, colls);
+    }
     void separateCollisions(MeshDict& outgoing, bool dest, int nColl,
-                            DetailedCollision* colls) const;
+                            DetailedCollision* colls) const {
+      exam2m::separateCollisions(proxyMap, outgoing, dest, nColl, colls);
+    }
 
     void allSent(int);
     void collsReceived();
     void checkReceived();
     void checkDone(int);
+
+    //! Add time spent in a transfer phase on this PE
+    void addTime(Phase p, double t) {
+      m_phaseTime[ static_cast< std::size_t >( p ) ] += t;
+    }
+    //! Record that boxes have been registered on this PE
+    void registered() { m_registered = CkWallTimer(); }
+    //! Record that solution data has been received on this PE
+    void received() { m_received = CkWallTimer(); }
+
+    void reportTimings(int it, const std::string& csvfile, CkCallback cb);
+    void timingsReduced(CkReductionMsg* msg);
+
+    //! Count broad-phase candidates tested and hits of a source chare
+    void sourceCounts(int chunk, std::size_t candidates, std::size_t hits);
+    //! Count points, misses, and candidates per point of a destination chare
+    void destCounts(int chunk, const std::vector< uint32_t >& candidates,
+                    const std::vector< char >& found);
+
+    void reportDiagnostics(int it, int topn, const std::string& csvfile,
+                           CkCallback cb);
+    void diagnosticsReduced(CkReductionMsg* msg);
+
+    //! Send potential collisions of a dest chare to a source chare
+    void sendCandidates(CandidateBatch&& b);
+    //! Send solution data of a source chare to a dest chare
+    void sendSolution(SolutionBatch&& b);
+    //! Send all aggregation buffers
+    void flushAggregates(bool idle);
+    //! Deliver aggregated messages to mesh chares on this node
+    void deliver(AggregateBuffer buf);
 };
 
 }
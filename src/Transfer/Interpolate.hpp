@@ -0,0 +1,399 @@
+// *****************************************************************************
+/*!
+  \file      src/Transfer/Interpolate.hpp
+  \copyright 2020 Charmworks, Inc.
+             All rights reserved. See the LICENSE file for details.
+  \brief     Point-in-element tests and interpolation kernels of the transfer
+  \details   Point-in-element tests and interpolation kernels of the transfer.
+    These are free functions, independent of the Charm++ chares driving the
+    transfer, so they can also be used, e.g., benchmarked, in isolation.
+*/
+// *****************************************************************************
+#ifndef Interpolate_h
+#define Interpolate_h
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "Types.hpp"
+#include "UnsMesh.hpp"
+
+namespace exam2m {
+
+inline bool
+intet( const std::vector< tk::lindex >& inpoel,
+       const tk::UnsMesh::Coords& coord,
+       const std::array< tk::real, 3 >& point,
+       std::size_t e,
+       std::array< tk::real, 4 >& N )
+// *****************************************************************************
+//  Determine if a point is in a tetrahedron and evaluate the shapefunction
+//! \param[in] inpoel Mesh element connectivity
+//! \param[in] coord Mesh node coordinates
+//! \param[in] point Point coordinates
+//! \param[in] e Mesh cell index
+//! \param[in,out] N Shapefunctions evaluated at the point
+//! \return True if ppoint is in mesh cell
+//! \see Lohner, An Introduction to Applied CFD Techniques, Wiley, 2008
+// *****************************************************************************
+{
+  using tk::real;
+
+  // Tetrahedron node indices
+  const auto A = inpoel[e*4+0];
+  const auto B = inpoel[e*4+1];
+  const auto C = inpoel[e*4+2];
+  const auto D = inpoel[e*4+3];
+
+  // Tetrahedron node coordinates
+  const auto& x = coord[0];
+  const auto& y = coord[1];
+  const auto& z = coord[2];
+
+  // Point coordinates
+  const auto& xp = point[0];
+  const auto& yp = point[1];
+  const auto& zp = point[2];
+
+  // Evaluate linear shapefunctions at point locations using Cramer's Rule
+  //    | xp |   | x1 x2 x3 x4 |   | N1 |
+  //    | yp | = | y1 y2 y3 y4 | • | N2 |
+  //    | zp |   | z1 z2 z3 z4 |   | N3 |
+  //    | 1  |   | 1  1  1  1  |   | N4 |
+
+  real DetX = (y[B]*z[C] - y[C]*z[B] - y[B]*z[D] + y[D]*z[B] +
+      y[C]*z[D] - y[D]*z[C])*x[A] + x[B]*y[C]*z[A] - x[B]*y[A]*z[C] +
+    x[C]*y[A]*z[B] - x[C]*y[B]*z[A] + x[B]*y[A]*z[D] - x[B]*y[D]*z[A] -
+    x[D]*y[A]*z[B] + x[D]*y[B]*z[A] - x[C]*y[A]*z[D] + x[C]*y[D]*z[A] +
+    x[D]*y[A]*z[C] - x[D]*y[C]*z[A] - x[B]*y[C]*z[D] + x[B]*y[D]*z[C] +
+    x[C]*y[B]*z[D] - x[C]*y[D]*z[B] - x[D]*y[B]*z[C] + x[D]*y[C]*z[B];
+
+  real DetX1 = (y[D]*z[C] - y[C]*z[D] + y[C]*zp - yp*z[C] -
+      y[D]*zp + yp*z[D])*x[B] + x[C]*y[B]*z[D] - x[C]*y[D]*z[B] -
+    x[D]*y[B]*z[C] + x[D]*y[C]*z[B] - x[C]*y[B]*zp + x[C]*yp*z[B] +
+    xp*y[B]*z[C] - xp*y[C]*z[B] + x[D]*y[B]*zp - x[D]*yp*z[B] -
+    xp*y[B]*z[D] + xp*y[D]*z[B] + x[C]*y[D]*zp - x[C]*yp*z[D] -
+    x[D]*y[C]*zp + x[D]*yp*z[C] + xp*y[C]*z[D] - xp*y[D]*z[C];
+
+  real DetX2 = (y[C]*z[D] - y[D]*z[C] - y[C]*zp + yp*z[C] +
+      y[D]*zp - yp*z[D])*x[A] + x[C]*y[D]*z[A] - x[C]*y[A]*z[D] +
+    x[D]*y[A]*z[C] - x[D]*y[C]*z[A] + x[C]*y[A]*zp - x[C]*yp*z[A] -
+    xp*y[A]*z[C] + xp*y[C]*z[A] - x[D]*y[A]*zp + x[D]*yp*z[A] +
+    xp*y[A]*z[D] - xp*y[D]*z[A] - x[C]*y[D]*zp + x[C]*yp*z[D] +
+    x[D]*y[C]*zp - x[D]*yp*z[C] - xp*y[C]*z[D] + xp*y[D]*z[C];
+
+  real DetX3 = (y[D]*z[B] - y[B]*z[D] + y[B]*zp - yp*z[B] -
+      y[D]*zp + yp*z[D])*x[A] + x[B]*y[A]*z[D] - x[B]*y[D]*z[A] -
+    x[D]*y[A]*z[B] + x[D]*y[B]*z[A] - x[B]*y[A]*zp + x[B]*yp*z[A] +
+    xp*y[A]*z[B] - xp*y[B]*z[A] + x[D]*y[A]*zp - x[D]*yp*z[A] -
+    xp*y[A]*z[D] + xp*y[D]*z[A] + x[B]*y[D]*zp - x[B]*yp*z[D] -
+    x[D]*y[B]*zp + x[D]*yp*z[B] + xp*y[B]*z[D] - xp*y[D]*z[B];
+
+  real DetX4 = (y[B]*z[C] - y[C]*z[B] - y[B]*zp + yp*z[B] +
+      y[C]*zp - yp*z[C])*x[A] + x[B]*y[C]*z[A] - x[B]*y[A]*z[C] +
+    x[C]*y[A]*z[B] - x[C]*y[B]*z[A] + x[B]*y[A]*zp - x[B]*yp*z[A] -
+    xp*y[A]*z[B] + xp*y[B]*z[A] - x[C]*y[A]*zp + x[C]*yp*z[A] +
+    xp*y[A]*z[C] - xp*y[C]*z[A] - x[B]*y[C]*zp + x[B]*yp*z[C] +
+    x[C]*y[B]*zp - x[C]*yp*z[B] - xp*y[B]*z[C] + xp*y[C]*z[B];
+
+  // Shape functions evaluated at point
+  N[0] = DetX1/DetX;
+  N[1] = DetX2/DetX;
+  N[2] = DetX3/DetX;
+  N[3] = DetX4/DetX;
+
+  // if min( N^i, 1-N^i ) > 0 for all i, point is in cell
+  if ( std::min(N[0],1.0-N[0]) > 0 && std::min(N[1],1.0-N[1]) > 0 &&
+      std::min(N[2],1.0-N[2]) > 0 && std::min(N[3],1.0-N[3]) > 0 )
+  {
+    return true;
+  } else {
+    return false;
+  }
+}
+
+inline std::array< tk::real, 3 >
+closestOnTri( const std::array< tk::real, 3 >& a,
+              const std::array< tk::real, 3 >& b,
+              const std::array< tk::real, 3 >& c,
+              const std::array< tk::real, 3 >& p )
+// *****************************************************************************
+//  Find the point of a triangle closest to a point
+//! \param[in] a First triangle node coordinates
+//! \param[in] b Second triangle node coordinates
+//! \param[in] c Third triangle node coordinates
+//! \param[in] p Point coordinates
+//! \return Barycentric coordinates of the point of the triangle closest to p
+//! \details Determines the Voronoi region of the triangle's vertices, edges,
+//!   or interior p is in, and projects p to the closest feature.
+//! \see Ericson, Real-Time Collision Detection, Morgan Kaufmann, 2005, 5.1.5
+// *****************************************************************************
+{
+  using tk::real;
+
+  auto dot = []( const std::array< real, 3 >& u,
+                 const std::array< real, 3 >& v )
+             { return u[0]*v[0] + u[1]*v[1] + u[2]*v[2]; };
+  auto sub = []( const std::array< real, 3 >& u,
+                 const std::array< real, 3 >& v ) -> std::array< real, 3 >
+             { return {{ u[0]-v[0], u[1]-v[1], u[2]-v[2] }}; };
+
+  const auto ab = sub( b, a );
+  const auto ac = sub( c, a );
+
+  // Vertex region of a
+  const auto ap = sub( p, a );
+  const auto d1 = dot( ab, ap );
+  const auto d2 = dot( ac, ap );
+  if (d1 <= 0.0 && d2 <= 0.0) return {{ 1.0, 0.0, 0.0 }};
+
+  // Vertex region of b
+  const auto bp = sub( p, b );
+  const auto d3 = dot( ab, bp );
+  const auto d4 = dot( ac, bp );
+  if (d3 >= 0.0 && d4 <= d3) return {{ 0.0, 1.0, 0.0 }};
+
+  // Edge region of ab
+  const auto vc = d1*d4 - d3*d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+    const auto v = d1 / (d1 - d3);
+    return {{ 1.0-v, v, 0.0 }};
+  }
+
+  // Vertex region of c
+  const auto cp = sub( p, c );
+  const auto d5 = dot( ab, cp );
+  const auto d6 = dot( ac, cp );
+  if (d6 >= 0.0 && d5 <= d6) return {{ 0.0, 0.0, 1.0 }};
+
+  // Edge region of ac
+  const auto vb = d5*d2 - d1*d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+    const auto w = d2 / (d2 - d6);
+    return {{ 1.0-w, 0.0, w }};
+  }
+
+  // Edge region of bc
+  const auto va = d3*d6 - d5*d4;
+  if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) {
+    const auto w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    return {{ 0.0, 1.0-w, w }};
+  }
+
+  // Interior
+  const auto denom = 1.0 / (va + vb + vc);
+  const auto v = vb * denom;
+  const auto w = vc * denom;
+  return {{ 1.0-v-w, v, w }};
+}
+
+inline bool
+ontri( const std::vector< tk::lindex >& inpoel,
+       const tk::UnsMesh::Coords& coord,
+       const std::array< tk::real, 3 >& point,
+       std::size_t e,
+       tk::real tol,
+       std::array< tk::real, 3 >& N,
+       tk::real& dist )
+// *****************************************************************************
+//  Determine if a point is within a distance of a triangle and evaluate the
+//  shapefunctions at its projection to the triangle
+//! \param[in] inpoel Surface triangle connectivity
+//! \param[in] coord Mesh node coordinates
+//! \param[in] point Point coordinates
+//! \param[in] e Surface triangle index
+//! \param[in] tol Largest distance of the point from the triangle accepted
+//! \param[in,out] N Shapefunctions evaluated at the point of the triangle
+//!   closest to point, i.e., its barycentric coordinates
+//! \param[in,out] dist Distance of the point from the triangle
+//! \return True if the point is within tol of the triangle
+// *****************************************************************************
+{
+  const auto A = inpoel[e*3+0];
+  const auto B = inpoel[e*3+1];
+  const auto C = inpoel[e*3+2];
+
+  const auto& x = coord[0];
+  const auto& y = coord[1];
+  const auto& z = coord[2];
+
+  N = closestOnTri( {{ x[A], y[A], z[A] }}, {{ x[B], y[B], z[B] }},
+                    {{ x[C], y[C], z[C] }}, point );
+
+  const auto dx = N[0]*x[A] + N[1]*x[B] + N[2]*x[C] - point[0];
+  const auto dy = N[0]*y[A] + N[1]*y[B] + N[2]*y[C] - point[1];
+  const auto dz = N[0]*z[A] + N[1]*z[B] + N[2]*z[C] - point[2];
+  dist = std::sqrt( dx*dx + dy*dy + dz*dz );
+
+  return dist <= tol;
+}
+
+//! Largest number of nodes of the source cells supported (hexahedron)
+static constexpr std::size_t MAX_NNPE = 8;
+
+inline void
+cellShape( std::size_t nnpe,
+           const std::array< tk::real, 3 >& xi,
+           std::array< tk::real, MAX_NNPE >& N,
+           std::array< std::array< tk::real, 3 >, MAX_NNPE >& dN )
+// *****************************************************************************
+//  Evaluate the shapefunctions of a cell and their derivatives
+//! \param[in] nnpe Number of nodes of the cell: 4 (tetrahedron), 5 (pyramid),
+//!   6 (prism), or 8 (hexahedron)
+//! \param[in] xi Reference coordinates of the point
+//! \param[in,out] N Shapefunctions evaluated at xi, the first nnpe are set
+//! \param[in,out] dN Derivatives of the shapefunctions with respect to xi
+//! \details Nodes are numbered in the ExodusII order. The reference cells
+//!   span [0,1] in each direction: the unit tetrahedron, the unit square base
+//!   with apex at xi[2] = 1 for the pyramid, the unit triangle extruded along
+//!   xi[2] for the prism, and the unit cube for the hexahedron, whose
+//!   shapefunctions are trilinear. The pyramid is a hexahedron with its top
+//!   face collapsed to the apex, so it is linear on its triangular faces and
+//!   conforms to neighboring tetrahedra.
+// *****************************************************************************
+{
+  using tk::real;
+
+  const auto r = xi[0];
+  const auto s = xi[1];
+  const auto t = xi[2];
+
+  // Corners of the unit square in counter-clockwise order
+  static const std::array< std::array< real, 2 >, 4 >
+    quad{{ {{0.0,0.0}}, {{1.0,0.0}}, {{1.0,1.0}}, {{0.0,1.0}} }};
+
+  // Bilinear shapefunction of a quad corner times a linear one in xi[2]
+  auto bilinear = [&]( std::size_t j, std::size_t c, real ft, real dt ) {
+    const auto fr = quad[c][0] > 0.0 ? r : 1.0-r;
+    const auto fs = quad[c][1] > 0.0 ? s : 1.0-s;
+    const auto dr = quad[c][0] > 0.0 ? 1.0 : -1.0;
+    const auto ds = quad[c][1] > 0.0 ? 1.0 : -1.0;
+    N[j] = fr*fs*ft;
+    dN[j] = {{ dr*fs*ft, fr*ds*ft, fr*fs*dt }};
+  };
+
+  if (nnpe == 4) {              // tetrahedron
+
+    N[0] = 1.0-r-s-t;  dN[0] = {{ -1.0, -1.0, -1.0 }};
+    N[1] = r;          dN[1] = {{  1.0,  0.0,  0.0 }};
+    N[2] = s;          dN[2] = {{  0.0,  1.0,  0.0 }};
+    N[3] = t;          dN[3] = {{  0.0,  0.0,  1.0 }};
+
+  } else if (nnpe == 5) {       // pyramid
+
+    for (std::size_t c=0; c<4; ++c) bilinear( c, c, 1.0-t, -1.0 );
+    N[4] = t;          dN[4] = {{  0.0,  0.0,  1.0 }};
+
+  } else if (nnpe == 6) {       // prism
+
+    const auto w = 1.0-r-s;
+    N[0] = w*(1.0-t);  dN[0] = {{ t-1.0, t-1.0,    -w }};
+    N[1] = r*(1.0-t);  dN[1] = {{ 1.0-t,   0.0,    -r }};
+    N[2] = s*(1.0-t);  dN[2] = {{   0.0, 1.0-t,    -s }};
+    N[3] = w*t;        dN[3] = {{    -t,    -t,     w }};
+    N[4] = r*t;        dN[4] = {{     t,   0.0,     r }};
+    N[5] = s*t;        dN[5] = {{   0.0,     t,     s }};
+
+  } else {                      // hexahedron
+
+    for (std::size_t c=0; c<4; ++c) {
+      bilinear( c, c, 1.0-t, -1.0 );
+      bilinear( c+4, c, t, 1.0 );
+    }
+
+  }
+}
+
+inline bool
+incell( const std::vector< tk::lindex >& inpoel,
+        std::size_t first,
+        std::size_t nnpe,
+        const tk::UnsMesh::Coords& coord,
+        const std::array< tk::real, 3 >& point,
+        std::array< tk::real, MAX_NNPE >& N )
+// *****************************************************************************
+//  Determine if a point is in a cell and evaluate the shapefunctions
+//! \param[in] inpoel Mesh element connectivity
+//! \param[in] first Position of the first node of the cell in inpoel
+//! \param[in] nnpe Number of nodes of the cell, see cellShape()
+//! \param[in] coord Mesh node coordinates
+//! \param[in] point Point coordinates
+//! \param[in,out] N Shapefunctions evaluated at the point, the first nnpe
+//!   are set
+//! \return True if point is in mesh cell
+//! \details Inverts the isoparametric map of the cell, e.g., trilinear for
+//!   hexahedra, by Newton's method started from the centroid of the reference
+//!   cell, which converges in a single iteration for tetrahedra and in a few
+//!   for other cells that are not strongly distorted. The point is in the
+//!   cell if all shapefunctions are non-negative at its reference
+//!   coordinates, up to a tolerance of the order of the Newton iteration's,
+//!   so points on faces shared by cells are found in either. Points for which
+//!   the iteration does not converge, e.g., far outside a distorted cell, are
+//!   reported outside.
+// *****************************************************************************
+{
+  using tk::real;
+
+  const std::size_t maxit = 20;
+  const real tol = 1.0e-12;
+
+  // Cell node coordinates
+  std::array< std::array< real, 3 >, MAX_NNPE > X;
+  for (std::size_t j=0; j<nnpe; ++j) {
+    const auto p = inpoel[ first+j ];
+    X[j] = {{ coord[0][p], coord[1][p], coord[2][p] }};
+  }
+
+  // Start from the centroid of the reference cell
+  std::array< real, 3 > xi{{ 0.5, 0.5, 0.5 }};
+  if (nnpe == 4) xi = {{ 0.25, 0.25, 0.25 }};
+  else if (nnpe == 5) xi = {{ 0.5, 0.5, 0.2 }};
+  else if (nnpe == 6) xi = {{ 1.0/3.0, 1.0/3.0, 0.5 }};
+
+  std::array< std::array< real, 3 >, MAX_NNPE > dN;
+  bool converged = false;
+  for (std::size_t it=0; it<maxit && !converged; ++it) {
+    cellShape( nnpe, xi, N, dN );
+
+    // Residual x(xi) - point and Jacobian J_ab = dx_a/dxi_b of the map
+    std::array< real, 3 > f{{ -point[0], -point[1], -point[2] }};
+    std::array< std::array< real, 3 >, 3 > J{{ {{0.0,0.0,0.0}},
+                                                {{0.0,0.0,0.0}},
+                                                {{0.0,0.0,0.0}} }};
+    for (std::size_t j=0; j<nnpe; ++j)
+      for (std::size_t a=0; a<3; ++a) {
+        f[a] += N[j] * X[j][a];
+        for (std::size_t b=0; b<3; ++b) J[a][b] += X[j][a] * dN[j][b];
+      }
+
+    // Solve J dxi = f using Cramer's rule
+    const auto det = J[0][0]*(J[1][1]*J[2][2] - J[1][2]*J[2][1])
+                   - J[0][1]*(J[1][0]*J[2][2] - J[1][2]*J[2][0])
+                   + J[0][2]*(J[1][0]*J[2][1] - J[1][1]*J[2][0]);
+    if (!(std::abs(det) > 0.0)) return false;
+    std::array< real, 3 > dxi;
+    for (std::size_t b=0; b<3; ++b) {
+      auto M = J;
+      for (std::size_t a=0; a<3; ++a) M[a][b] = f[a];
+      dxi[b] = ( M[0][0]*(M[1][1]*M[2][2] - M[1][2]*M[2][1])
+               - M[0][1]*(M[1][0]*M[2][2] - M[1][2]*M[2][0])
+               + M[0][2]*(M[1][0]*M[2][1] - M[1][1]*M[2][0]) ) / det;
+    }
+
+    for (std::size_t b=0; b<3; ++b) xi[b] -= dxi[b];
+    converged = std::max( { std::abs(dxi[0]), std::abs(dxi[1]),
+                            std::abs(dxi[2]) } ) < tol;
+  }
+  if (!converged) return false;
+
+  // Shape functions evaluated at point
+  cellShape( nnpe, xi, N, dN );
+
+  return *std::min_element( N.cbegin(), N.cbegin() + nnpe ) > -1.0e-10;
+}
+
+} // exam2m::
+
+#endif // Interpolate_h
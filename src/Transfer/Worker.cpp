@@ -9,11 +9,19 @@
 // *****************************************************************************
 
 #include <iostream>     // NOT NEEDED WHEN DEBUGGED
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
 
 #include "Worker.hpp"
+#include "Exception.hpp"
 #include "Reorder.hpp"
 #include "DerivedData.hpp"
 #include "Controller.hpp"
+#include "Interpolate.hpp"
+#include "ParallelFor.hpp"
+#include "UnsMesh.hpp"
 
 #include "collidecharm.h"
 
@@ -34,12 +42,35 @@ PUPbytes(Collision);
 namespace exam2m {
 extern CollideHandle collideHandle;
 extern CProxy_Controller controllerProxy;
+extern int g_parallelGrain;
+
+//! Identifies transfer plan files and their format version
+static constexpr std::uint64_t PLAN_MAGIC = 0x6e616c706d326d02ULL;
 }
 
 using exam2m::Worker;
 
 Worker::Worker( CkArrayID p, MeshData d, CkCallback cb ) :
-    m_firstchunk(d.m_firstchunk)
+    m_firstchunk(d.m_firstchunk),
+    m_array(p),
+    m_inpoel(nullptr),
+    m_cellptr(nullptr),
+    m_surface(false),
+    m_tol(0.0),
+    m_nw(4),
+    m_field(SourceField::NODE),
+    m_elems(nullptr),
+    m_coord(nullptr),
+    m_u(nullptr),
+    m_usrc(nullptr),
+    m_points(nullptr),
+    m_transfer(0),
+    m_ready(true),
+    m_waiting(false),
+    m_load(0.0),
+    m_weights(false),
+    m_wstride(4),
+    m_applying(false)
 // *****************************************************************************
 //  Constructor
 //! \param[in] firstchunk Chunk ID used for the collision detection library
@@ -48,45 +79,293 @@ Worker::Worker( CkArrayID p, MeshData d, CkCallback cb ) :
 {
   CollideRegister(collideHandle, m_firstchunk + thisIndex);
   d.m_proxy = thisProxy;
+  m_mesh = d;
   controllerProxy.ckLocalBranch()->setMesh( p, d );
   contribute(cb);
 }
 
+void
+Worker::ckAboutToMigrate()
+// *****************************************************************************
+//  Unregister from the collision detection library before migration
+// *****************************************************************************
+{
+  CollideUnregister(collideHandle, m_firstchunk + thisIndex);
+}
+
+void
+Worker::ckJustMigrated()
+// *****************************************************************************
+//  Register with the collision detection library and controller after
+//  migration
+//! \details The controller on the new PE may not yet know about this mesh if
+//!   none of its chares were created there.
+// *****************************************************************************
+{
+  CBase_Worker::ckJustMigrated();
+  CollideRegister(collideHandle, m_firstchunk + thisIndex);
+  controllerProxy.ckLocalBranch()->setMesh( m_array, m_mesh );
+}
+
+double
+Worker::load()
+// *****************************************************************************
+//  Return and reset the transfer time spent since the last call
+//! \return Wall-clock time spent in determineActualCollisions() as source,
+//!   and in processCollisions(), transferSolution(), applyTransfer(), and
+//!   applyWeights() as dest, in seconds
+//! \details Used as the measured load of the bound application chare for
+//!   load balancing. Checking the candidates as source dominates the
+//!   transfer cost and varies strongly between chares, while the dest work
+//!   keeps chares that are only dest from reporting no load at all.
+// *****************************************************************************
+{
+  auto l = m_load;
+  m_load = 0.0;
+  return l;
+}
+
 void
 Worker::setSourceTets(
-    std::vector< std::size_t>* inpoel,
+    std::vector< tk::lindex >* inpoel,
     tk::UnsMesh::Coords* coords,
-    const tk::Fields& u )
+    const tk::Fields& u,
+    const std::vector< tk::lindex >* elems,
+    SourceField field )
 // *****************************************************************************
 //  Set the data for the source tetrahedrons to be collided
 //! \param[in] inpoel Pointer to the connectivity data for the source mesh
 //! \param[in] coords Pointer to the coordinate data for the source mesh
 //! \param[in] u Pointer to the solution data for the source mesh
+//! \param[in] elems Pointer to the ids of the tets to transfer from, e.g., the
+//!   tets overlapping a region of interest, all tets if nullptr. Only these
+//!   are registered with the collision detection library. Must stay valid
+//!   until the transfer is complete.
+//! \param[in] field Location of the solution values, in the nodes or the
+//!   cells, see setField()
+//! \details The solution is not copied, so it must stay unchanged until the
+//!   transfer is complete, i.e., until its ready callback is called.
 // *****************************************************************************
 {
+  setField( field, u, inpoel->size() / 4 );
   m_coord = coords;
-  m_u = const_cast< tk::Fields* >( &u );
+  m_usrc = &u;
   m_inpoel = inpoel;
+  m_cellptr = nullptr;
+  m_elems = elems;
+  m_surface = false;
+  m_nw = field == SourceField::NODE ? 4 : 1;
+  m_targets.clear();
 
   // Send tetrahedron data to the collision detection library
   collideTets();
 }
 
+void
+Worker::setSourceCells(
+    std::vector< tk::lindex >* inpoel,
+    const std::vector< std::size_t >* cellptr,
+    tk::UnsMesh::Coords* coords,
+    const tk::Fields& u,
+    const std::vector< tk::lindex >* elems,
+    SourceField field )
+// *****************************************************************************
+//  Set the data for the source cells of mixed type to be collided
+//! \param[in] inpoel Pointer to the connectivity data for the source mesh,
+//!   the nodes of each cell in ExodusII order
+//! \param[in] cellptr Pointer to the offsets of the cells in inpoel, one more
+//!   than the number of cells. The number of nodes of a cell determines its
+//!   type: 4 (tetrahedron), 5 (pyramid), 6 (prism), or 8 (hexahedron).
+//! \param[in] coords Pointer to the coordinate data for the source mesh
+//! \param[in] u Pointer to the solution data for the source mesh
+//! \param[in] elems Pointer to the ids of the cells to transfer from, all
+//!   cells if nullptr, see setSourceTets()
+//! \param[in] field Location of the solution values, in the nodes or the
+//!   cells, see setField()
+//! \details Dest points are located in the cells by inverting their
+//!   isoparametric map, e.g., trilinear for hexahedra, see exam2m::incell(),
+//!   so hex-dominant meshes need not be tetrahedralized for the transfer. The
+//!   solution is not copied, so it must stay unchanged until the transfer is
+//!   complete, see setSourceTets().
+// *****************************************************************************
+{
+  ErrChk( !cellptr->empty() && cellptr->front() == 0 &&
+          cellptr->back() == inpoel->size(),
+          "Source cell offsets inconsistent with connectivity" );
+
+  m_nw = 0;
+  for (std::size_t e=0; e+1<cellptr->size(); ++e) {
+    auto n = (*cellptr)[e+1] - (*cellptr)[e];
+    ErrChk( n == 4 || n == 5 || n == 6 || n == 8,
+            "Unsupported source cell with " + std::to_string(n) + " nodes" );
+    m_nw = std::max( m_nw, n );
+  }
+  setField( field, u, cellptr->size() - 1 );
+  if (field != SourceField::NODE) m_nw = 1;
+
+  m_coord = coords;
+  m_usrc = &u;
+  m_inpoel = inpoel;
+  m_cellptr = cellptr;
+  m_elems = elems;
+  m_surface = false;
+  m_targets.clear();
+
+  // Send cell data to the collision detection library
+  collideTets();
+}
+
+void
+Worker::setSourceTris(
+    std::vector< tk::lindex >* triinpoel,
+    tk::UnsMesh::Coords* coords,
+    const tk::Fields& u,
+    tk::real tol,
+    const std::vector< tk::lindex >* elems )
+// *****************************************************************************
+//  Set the data for the source surface triangles to be collided
+//! \param[in] triinpoel Pointer to the connectivity of the source surface
+//!   triangles, using the node ids of the source mesh
+//! \param[in] coords Pointer to the coordinate data for the source mesh
+//! \param[in] u Pointer to the solution data for the source mesh
+//! \param[in] tol Largest distance of a dest point from the source surface at
+//!   which it still receives a value
+//! \param[in] elems Pointer to the ids of the triangles to transfer from, all
+//!   triangles if nullptr, see setSourceTets()
+//! \details Dest points are projected to the closest point of the surface
+//!   triangles within tol and receive the value interpolated there, so the
+//!   dest points need not lie exactly on the source surface, as is usual for
+//!   curved surfaces discretized differently. The solution is not copied, so it
+//!   must stay unchanged until the transfer is complete, see setSourceTets().
+// *****************************************************************************
+{
+  ErrChk( tol >= 0.0, "Surface transfer tolerance must be non-negative" );
+
+  m_coord = coords;
+  m_usrc = &u;
+  m_inpoel = triinpoel;
+  m_cellptr = nullptr;
+  m_elems = elems;
+  m_surface = true;
+  m_tol = tol;
+  m_nw = 3;
+  m_field = SourceField::NODE;
+  m_targets.clear();
+
+  // Send triangle data to the collision detection library
+  collideTets();
+}
+
+void
+Worker::setField( SourceField field,
+                  const tk::Fields& u,
+                  std::size_t ncells )
+// *****************************************************************************
+//  Set the location of the source solution values after checking them
+//! \param[in] field Location of the solution values, in the nodes or the
+//!   cells of the source mesh
+//! \param[in] u Solution data for the source mesh
+//! \param[in] ncells Number of source cells
+//! \details Cell fields hold a value per cell, e.g., the cell averages of a
+//!   finite volume code, which are transferred without averaging them to the
+//!   nodes first. A dest point in a cell receives the value of the cell
+//!   (SourceField::CELL), or, with its gradient given in components 1, 2,
+//!   and 3, the value linearly reconstructed about the centroid of the cell,
+//!   i.e., the average of the coordinates of its nodes
+//!   (SourceField::CELL_LINEAR). Since the gradients are those of the
+//!   application, the transfer needs no data of neighboring cells.
+// *****************************************************************************
+{
+  if (field != SourceField::NODE)
+    ErrChk( u.nunk() == ncells,
+            "Source cell field must hold a value per source cell" );
+  if (field == SourceField::CELL_LINEAR)
+    ErrChk( u.nprop() >= 4,
+            "Source cell field must hold the value and its gradient" );
+  m_field = field;
+}
+
 void
 Worker::setDestPoints(
     tk::UnsMesh::Coords* coords,
     const tk::Fields& u,
-    CkCallback cb )
+    CkCallback cb,
+    const std::vector< tk::lindex >* points )
 // *****************************************************************************
 //  Set the data for the destination points to be collided
 //! \param[in] coords Pointer to the coordinate data for the destination mesh
 //! \param[in] u Pointer to the solution data for the destination mesh
 //! \param[in] cb Callback to call once this chare received all solution data
+//! \param[in] points Pointer to the ids of the dest mesh nodes to transfer
+//!   into, all nodes if nullptr, see startTransfer()
+//! \details Starts a transfer and waits for it right away, so the solution
+//!   data is applied to u as soon as it has all arrived.
 // *****************************************************************************
 {
+  auto id = startTransfer( coords, const_cast< tk::Fields& >( u ),
+                           CkCallback( CkCallback::ignore ), false, points );
+  waitTransfer( id, cb );
+}
+
+int
+Worker::startTransfer(
+    tk::UnsMesh::Coords* coords,
+    tk::Fields& u,
+    CkCallback cb,
+    bool weights,
+    const std::vector< tk::lindex >* points )
+// *****************************************************************************
+//  Start a split-phase transfer into the destination mesh
+//! \param[in] coords Pointer to the coordinate data for the destination mesh
+//! \param[in] u Solution data for the destination mesh, only written by
+//!   applyTransfer() once waited on
+//! \param[in] cb Callback to call once all solution data has arrived
+//! \param[in] weights True to also collect the interpolation weights, which
+//!   are then available from weights() and can be reapplied to new source
+//!   values by applySource() and applyDest() until the next transfer
+//! \param[in] points Pointer to the ids of the dest mesh nodes to transfer
+//!   into, e.g., the nodes of a surface, all nodes if nullptr. Only these are
+//!   registered with the collision detection library, so the cost of the
+//!   transfer scales with their number. Must stay valid until the transfer
+//!   is complete.
+//! \return Sequence number of the transfer to be passed to transferReady()
+//!   and waitTransfer()
+//! \details The solution data received is staged in a separate buffer, so
+//!   the application may keep working on u while the transfer is in
+//!   progress, and only written to u when the application waits for the
+//!   transfer, either right away or after cb has been called. The solution
+//!   of the source mesh is not staged, so it must stay unchanged until cb is
+//!   called, see setSourceTets().
+// *****************************************************************************
+{
+  ErrChk( m_ready && !m_waiting && !m_applying,
+          "Transfer started before the previous one has been completed" );
+
   m_coord = coords;
-  m_u = const_cast< tk::Fields* >( &u );
-  m_donecb = cb;
+  m_u = &u;
+  m_points = points;
+  m_readycb = cb;
+  m_ready = false;
+  m_weights = weights;
+
+  // Initialize staging buffer and diagnostics counters
+  const auto npoin = (*coords)[0].size();
+  m_staged.assign( npoin, 0.0 );
+  m_dist.assign( npoin, 0.0 );
+  m_candidates.assign( npoin, 0 );
+  m_found.assign( npoin, 0 );
+
+  // Initialize interpolation weights, four per point, grown if cells with more
+  // nodes are hit, see growWeights()
+  m_wchunk.assign( weights ? npoin : 0, -1 );
+  m_wchare.assign( weights ? npoin : 0, -1 );
+  m_wstride = 4;
+  m_wnode.assign( weights ? npoin*m_wstride : 0, 0 );
+  m_wpos.assign( weights ? npoin*m_wstride : 0, 0 );
+  m_wweight.assign( weights ? npoin*m_wstride : 0, 0.0 );
+  m_wsources.clear();
+  m_csr = TransferWeights();
+  m_applied.clear();
 
   // Initialize msg counters and callback
   m_numsent = 1; // Set to one to account for the extra message expected from
@@ -95,6 +374,280 @@ Worker::setDestPoints(
 
   // Send vertex data to the collision detection library
   collideVertices();
+
+  return ++m_transfer;
+}
+
+bool
+Worker::transferReady( int id ) const
+// *****************************************************************************
+//  Query if all data of a split-phase transfer has arrived
+//! \param[in] id Sequence number of the transfer returned by startTransfer()
+//! \return True if all solution data has arrived and waitTransfer() will
+//!   apply it without delay
+// *****************************************************************************
+{
+  Assert( id == m_transfer, "Unknown transfer" );
+  return m_ready;
+}
+
+void
+Worker::waitTransfer( int id, CkCallback cb )
+// *****************************************************************************
+//  Complete a split-phase transfer by applying the data received
+//! \param[in] id Sequence number of the transfer returned by startTransfer()
+//! \param[in] cb Callback to call once the solution data has been applied
+//! \details If all solution data has arrived, it is applied right away,
+//!   otherwise as soon as the last of it arrives. Either way the application
+//!   must not touch the dest solution between calling this and cb.
+// *****************************************************************************
+{
+  ErrChk( id == m_transfer && !m_waiting, "Unknown transfer" );
+
+  m_donecb = cb;
+  m_waiting = true;
+  if (m_ready) applyTransfer();
+}
+
+const exam2m::TransferWeights&
+Worker::weights() const
+// *****************************************************************************
+//  Return the interpolation weights of the last transfer into the dest mesh
+//! \return Interpolation weights in CSR form, one row per dest mesh point
+//! \details The weights allow the application to compute the transfer itself,
+//!   e.g., fused into its own kernels or blending two source states, given
+//!   the source values, which applySource() and applyDest() move without
+//!   repeating collision detection.
+// *****************************************************************************
+{
+  ErrChk( m_weights && m_ready,
+          "Interpolation weights not requested or transfer not complete" );
+  return m_csr;
+}
+
+void
+Worker::applySource( const tk::Fields& u )
+// *****************************************************************************
+//  Send the source values needed to apply the interpolation weights of the
+//  last transfer from this source mesh chare
+//! \param[in] u Source solution to send the values of
+//! \details Each dest mesh chare that received a value from this chare in
+//!   the last transfer with weights is sent the values of only the source
+//!   nodes its weights refer to, in the order established by that transfer.
+//!   Must be called once for each call of applyDest() on the dest mesh.
+// *****************************************************************************
+{
+  for (const auto& [ chunk, t ] : m_targets) {
+    std::vector< tk::real > vals( t.m_nodes.size() );
+    for (std::size_t i=0; i<vals.size(); ++i) vals[i] = u(t.m_nodes[i],0,0);
+    t.m_proxy[ t.m_index ].applyValues( m_firstchunk + thisIndex,
+                                        vals.size(), vals.data() );
+  }
+}
+
+void
+Worker::applyDest( tk::Fields& u, CkCallback cb )
+// *****************************************************************************
+//  Apply the interpolation weights of the last transfer to the source values
+//  received
+//! \param[in] u Solution data for the destination mesh
+//! \param[in] cb Callback to call once the weights have been applied to u
+//! \details Only points that received a value in the last transfer are
+//!   overwritten. The application must not touch u between calling this and
+//!   cb.
+// *****************************************************************************
+{
+  ErrChk( m_weights && m_ready && !m_waiting && !m_applying,
+          "Interpolation weights not requested or transfer not complete" );
+
+  m_u = &u;
+  m_applycb = cb;
+  m_applying = true;
+  applyWeights();
+}
+
+void
+Worker::applyValues( int chunk, std::size_t n, tk::real* vals )
+// *****************************************************************************
+//  Receive the source values needed to apply the interpolation weights
+//! \param[in] chunk Chunk id of the source mesh chare sending the values
+//! \param[in] n Number of values
+//! \param[in] vals Source values in the order of the positions received with
+//!   the weights
+// *****************************************************************************
+{
+  ErrChk( m_applied.emplace( chunk,
+            std::vector< tk::real >( vals, vals+n ) ).second,
+          "Source values sent twice before the weights were applied" );
+  applyWeights();
+}
+
+void
+Worker::hashMesh( const std::vector< tk::lindex >& inpoel,
+                  const tk::UnsMesh::Coords& coords,
+                  CkCallback cb )
+// *****************************************************************************
+//  Contribute the content hash of the mesh chunk to a reduction
+//! \param[in] inpoel Element connectivity of the mesh chunk
+//! \param[in] coords Node coordinates of the mesh chunk
+//! \param[in] cb Callback to send the content hash of the whole mesh to
+//! \details The hashes of the chunks are combined with the chare index and
+//!   summed, so the hash of the mesh changes with its connectivity, node
+//!   coordinates, and partitioning, but not with the order the chares
+//!   contribute in.
+// *****************************************************************************
+{
+  using highwayhash::SipHash;
+  const std::array< std::uint64_t, 5 > h{{
+    static_cast< std::uint64_t >( thisIndex ),
+    SipHash( tk::hh_key, reinterpret_cast< const char* >( inpoel.data() ),
+             inpoel.size() * sizeof(tk::lindex) ),
+    SipHash( tk::hh_key, reinterpret_cast< const char* >( coords[0].data() ),
+             coords[0].size() * sizeof(tk::real) ),
+    SipHash( tk::hh_key, reinterpret_cast< const char* >( coords[1].data() ),
+             coords[1].size() * sizeof(tk::real) ),
+    SipHash( tk::hh_key, reinterpret_cast< const char* >( coords[2].data() ),
+             coords[2].size() * sizeof(tk::real) ) }};
+  unsigned long long hash =
+    SipHash( tk::hh_key, reinterpret_cast< const char* >( h.data() ),
+             sizeof(h) );
+  contribute( sizeof(hash), &hash, CkReduction::sum_ulong_long, cb );
+}
+
+std::string
+Worker::planFile( const std::string& prefix, std::uint64_t key ) const
+// *****************************************************************************
+//  Return the name of the file storing the transfer plan of this chare
+//! \param[in] prefix File name prefix, may contain a path
+//! \param[in] key Transfer plan key, see exam2m::planKey()
+//! \return File name: prefix.key.chunk, with the key in hexadecimal
+// *****************************************************************************
+{
+  std::stringstream s;
+  s << prefix << '.' << std::hex << std::setw(16) << std::setfill('0') << key
+    << std::dec << '.' << m_firstchunk + thisIndex;
+  return s.str();
+}
+
+void
+Worker::pupPlan( PUP::er& p )
+// *****************************************************************************
+//  Pack/Unpack the transfer plan to/from file
+//! \param[in,out] p Charm++'s PUP::er serializer object reference
+//! \details The plan consists of the interpolation weights of the points of
+//!   this chare as dest and the source nodes each dest chare needs from this
+//!   chare as source. Dest chares are identified by their chunk ids, as
+//!   proxies are only valid within a run.
+// *****************************************************************************
+{
+  p | m_wchunk;
+  p | m_wchare;
+  p | m_wstride;
+  p | m_wnode;
+  p | m_wpos;
+  p | m_wweight;
+  p | m_wsources;
+
+  std::vector< int > chunk, index;
+  std::vector< std::vector< tk::lindex > > nodes;
+  if (!p.isUnpacking()) {
+    for (const auto& [ c, t ] : m_targets) {
+      chunk.push_back( c );
+      index.push_back( t.m_index );
+      nodes.push_back( t.m_nodes );
+    }
+  }
+  p | chunk;
+  p | index;
+  p | nodes;
+  if (p.isUnpacking()) {
+    auto ctrl = controllerProxy.ckLocalBranch();
+    m_targets.clear();
+    for (std::size_t i=0; i<chunk.size(); ++i) {
+      auto& t = m_targets[ chunk[i] ];
+      t.m_proxy = ctrl->chunkProxy( chunk[i] );
+      t.m_index = index[i];
+      t.m_nodes = std::move( nodes[i] );
+    }
+  }
+}
+
+void
+Worker::savePlan( const std::string& prefix, std::uint64_t key )
+// *****************************************************************************
+//  Save the transfer plan of the last transfer to file
+//! \param[in] prefix File name prefix, may contain a path
+//! \param[in] key Transfer plan key, see exam2m::planKey()
+//! \details The last transfer involving this chare must have collected the
+//!   interpolation weights. The file is written under a temporary name and
+//!   renamed when complete, so a concurrent loadPlan() never reads a partial
+//!   plan.
+// *****************************************************************************
+{
+  ErrChk( m_ready && !m_waiting && !m_applying,
+          "Transfer plan saved while a transfer is in progress" );
+
+  const auto file = planFile( prefix, key );
+  const auto tmp = file + ".tmp";
+  FILE* f = std::fopen( tmp.c_str(), "wb" );
+  ErrChk( f, "Failed to open file " + tmp );
+  {
+    PUP::toDisk p( f );
+    auto magic = PLAN_MAGIC;
+    int chunk = m_firstchunk + thisIndex;
+    p | magic;
+    p | key;
+    p | chunk;
+    pupPlan( p );
+  }
+  ErrChk( std::fclose( f ) == 0 && std::rename( tmp.c_str(), file.c_str() ) == 0,
+          "Failed to write file " + file );
+}
+
+bool
+Worker::loadPlan( const std::string& prefix, std::uint64_t key,
+                  std::size_t npoin )
+// *****************************************************************************
+//  Load a transfer plan from file
+//! \param[in] prefix File name prefix, may contain a path
+//! \param[in] key Transfer plan key, see exam2m::planKey()
+//! \param[in] npoin Number of points of this chare as dest, the number of
+//!   points the interpolation weights of the plan must be for
+//! \return True if the plan has been loaded, false if there is no plan for
+//!   this key and chare
+//! \details Once loaded, the plan is used by applySource() and applyDest()
+//!   and its weights are returned by weights(), exactly as if the transfer
+//!   the plan was saved from has just completed, without collision detection.
+// *****************************************************************************
+{
+  ErrChk( m_ready && !m_waiting && !m_applying,
+          "Transfer plan loaded while a transfer is in progress" );
+
+  FILE* f = std::fopen( planFile( prefix, key ).c_str(), "rb" );
+  if (!f) return false;
+  bool ok = false;
+  {
+    PUP::fromDisk p( f );
+    std::uint64_t magic = 0, k = 0;
+    int chunk = -1;
+    p | magic;
+    p | k;
+    p | chunk;
+    ok = magic == PLAN_MAGIC && k == key && chunk == m_firstchunk + thisIndex;
+    if (ok) pupPlan( p );
+  }
+  std::fclose( f );
+  if (!ok) return false;
+
+  ErrChk( m_wchunk.empty() || m_wchunk.size() == npoin, "Transfer plan " +
+          planFile( prefix, key ) + " has weights for " +
+          std::to_string( m_wchunk.size() ) + " dest points instead of " +
+          std::to_string( npoin ) );
+
+  m_weights = !m_wchunk.empty();
+  if (m_weights) buildWeights();
+  m_applied.clear();
+  return true;
 }
 
 void
@@ -103,46 +656,72 @@ Worker::collideVertices()
 // Pass vertex information to the collision detection library
 // *****************************************************************************
 {
+  auto t0 = CkWallTimer();
   const tk::UnsMesh::Coords& coord = *m_coord;
-  auto nVertices = coord[0].size();
+  auto nVertices = m_points ? m_points->size() : coord[0].size();
   std::size_t nBoxes = 0;
   std::vector< bbox3d > boxes( nVertices );
   std::vector< int > prio( nVertices );
   auto firstchunk = static_cast< int >( m_firstchunk );
   for (std::size_t i=0; i<nVertices; ++i) {
+    // Boxes are numbered by their position in m_points, if given
+    auto p = m_points ? (*m_points)[i] : i;
     boxes[nBoxes].empty();
-    boxes[nBoxes].add(CkVector3d(coord[0][i], coord[1][i], coord[2][i]));
+    boxes[nBoxes].add(CkVector3d(coord[0][p], coord[1][p], coord[2][p]));
     prio[nBoxes] = DEST_PRIO;
     ++nBoxes;
   }
   CollideBoxesPrio( collideHandle, firstchunk + thisIndex,
                     static_cast<int>(nBoxes), boxes.data(), prio.data() );
+
+  auto ctrl = controllerProxy.ckLocalBranch();
+  ctrl->addTime( Phase::REGISTER, CkWallTimer() - t0 );
+  ctrl->registered();
 }
 
 void
 Worker::collideTets() const
 // *****************************************************************************
-// Pass tet information to the collision detection library
+// Pass cell (or surface triangle) information to the collision detection
+// library
+//! \details Boxes of surface triangles are grown by the surface transfer
+//!   tolerance, so they collide with the dest points within that distance.
+//!   Boxes of cells of mixed type span all of their nodes.
 // *****************************************************************************
 {
-  const std::vector< std::size_t >& inpoel = *m_inpoel;
+  Assert( m_inpoel && m_coord, "Source mesh data not set on worker" );
+  auto t0 = CkWallTimer();
+  const std::vector< tk::lindex >& inpoel = *m_inpoel;
   const tk::UnsMesh::Coords& coord = *m_coord;
-  auto nBoxes = inpoel.size() / 4;
+  const std::size_t nnpe = m_surface ? 3 : 4;
+  const auto d = m_surface ? m_tol : 0.0;
+  auto nBoxes = m_elems ? m_elems->size() :
+                m_cellptr ? m_cellptr->size() - 1 : inpoel.size() / nnpe;
   std::vector< bbox3d > boxes( nBoxes );
   std::vector< int > prio( nBoxes );
   auto firstchunk = static_cast< int >( m_firstchunk );
   for (std::size_t i=0; i<nBoxes; ++i) {
     boxes[i].empty();
     prio[i] = SOURCE_PRIO;
-    for (std::size_t j=0; j<4; ++j) {
-      // Get index of the jth point of the ith tet
-      auto p = inpoel[i * 4 + j];
-      // Add that point to the tets bounding box
-      boxes[i].add(CkVector3d(coord[0][p], coord[1][p], coord[2][p]));
+    // Boxes are numbered by their position in m_elems, if given
+    auto e = m_elems ? (*m_elems)[i] : i;
+    auto first = m_cellptr ? (*m_cellptr)[e] : e * nnpe;
+    auto last = m_cellptr ? (*m_cellptr)[e+1] : first + nnpe;
+    for (auto j=first; j<last; ++j) {
+      // Get index of the jth point of the element
+      auto p = inpoel[j];
+      // Add that point to the element's bounding box
+      boxes[i].add(CkVector3d(coord[0][p]-d, coord[1][p]-d, coord[2][p]-d));
+      if (m_surface)
+        boxes[i].add(CkVector3d(coord[0][p]+d, coord[1][p]+d, coord[2][p]+d));
     }
   }
   CollideBoxesPrio( collideHandle, firstchunk + thisIndex,
                     static_cast<int>(nBoxes), boxes.data(), prio.data() );
+
+  auto ctrl = controllerProxy.ckLocalBranch();
+  ctrl->addTime( Phase::REGISTER, CkWallTimer() - t0 );
+  ctrl->registered();
 }
 
 void
@@ -154,205 +733,446 @@ Worker::processCollisions(
 //  that they potentially collide with.
 //! \param[in] nColl Number of potential collisions to process
 //! \param[in] colls List of potential collisions
+//! \details Filling in the points is done in parallel by the PEs of the
+//!   node for long lists of collisions, see g_parallelGrain.
 // *****************************************************************************
 {
+  auto t0 = CkWallTimer();
   const tk::UnsMesh::Coords& coord = *m_coord;
+  auto ctrl = controllerProxy.ckLocalBranch();
+  ctrl->collsReceived();
+
+  // Fill in the actual point for each collision
+  tk::parallelFor( static_cast< std::size_t >( nColl ),
+    [&]( std::size_t first, std::size_t last ){
+      for (auto c=first; c<last; ++c) {
+        auto& coll = colls[c];
+        CkAssert(coll.dest_chunk == mychunk);
+        // Convert box number to node id if only a subset was registered
+        if (m_points) coll.dest_index = (*m_points)[coll.dest_index];
+        #if defined(STRICT_GNUC)
+          #pragma GCC diagnostic push
+          #pragma GCC diagnostic ignored "-Wdeprecated-copy"
+        #endif
+        coll.point = { coord[0][coll.dest_index],
+                       coord[1][coll.dest_index],
+                       coord[2][coll.dest_index] };
+        #if defined(STRICT_GNUC)
+          #pragma GCC diagnostic pop
+        #endif
+      }
+    }, static_cast< std::size_t >( g_parallelGrain ) );
+  for (int c = 0; c < nColl; c++) ++m_candidates[colls[c].dest_index];
+  auto t1 = CkWallTimer();
+  ctrl->addTime( Phase::PROCESS, t1 - t0 );
 
   Controller::MeshDict outgoing;
   // Separate collisions for source meshes (dest = false)
-  controllerProxy.ckLocalBranch()->collsReceived();
-  controllerProxy.ckLocalBranch()->separateCollisions(outgoing, false, nColl, colls);
+  ctrl->separateCollisions(outgoing, false, nColl, colls);
+  auto t2 = CkWallTimer();
+  ctrl->addTime( Phase::SEPARATE, t2 - t1 );
 
   for (auto& itr : outgoing) {
     for (int i = 0; i < itr.first.m_nchare; i++) {
-      // Fill in the actual point for each collision
       if (itr.second[i].size()) {
-        for (auto& coll : itr.second[i]) {
-          CkAssert(coll.dest_chunk == mychunk);
-          #if defined(STRICT_GNUC)
-            #pragma GCC diagnostic push
-            #pragma GCC diagnostic ignored "-Wdeprecated-copy"
-          #endif
-          coll.point = { coord[0][coll.dest_index],
-                         coord[1][coll.dest_index],
-                         coord[2][coll.dest_index] };
-          #if defined(STRICT_GNUC)
-            #pragma GCC diagnostic pop
-          #endif
-        }
         m_numsent++;
-        itr.first.m_proxy[i].determineActualCollisions(
-            thisProxy, thisIndex, itr.second[i].size(), itr.second[i].data());
+        ctrl->sendCandidates( { itr.first.m_proxy, i, thisProxy, thisIndex,
+                                m_weights, std::move( itr.second[i] ) } );
       }
     }
   }
+
+  auto t3 = CkWallTimer();
+  ctrl->addTime( Phase::PROCESS, t3 - t2 );
+  m_load += t3 - t0;
 }
 
 void
 Worker::determineActualCollisions(
     CProxy_Worker proxy,
     int index,
+    bool weights,
     int nColls,
-    DetailedCollision* colls ) const
+    DetailedCollision* colls )
 // *****************************************************************************
 //  Identify actual collisions by calling intet on all possible collisions, and
 //  interpolate solution values to send back to the destination mesh.
 //! \param[in] proxy The proxy of the destination mesh chare array
 //! \param[in] index The index in proxy to return the solution data to
+//! \param[in] weights True to also send back the interpolation weights and
+//!   remember the source nodes they refer to for applySource()
 //! \param[in] nColls Number of collisions to be checked
 //! \param[in] colls List of potential collisions
+//! \details The collisions are checked in parallel by the PEs of the node
+//!   for long lists of collisions, see g_parallelGrain, so source chares
+//!   overlapping many destination points do not hold up the transfer. If the
+//!   source is a surface, each dest point is projected to the closest of the
+//!   candidate triangles within the tolerance, and its distance is sent along,
+//!   so the dest chare can keep the closest of multiple source chares. If the
+//!   source solution is a cell field, the dest points are located the same
+//!   way, but receive the value of the cell, see setField(), and a single
+//!   weight of one of the cell if requested.
 // *****************************************************************************
 {
-  const std::vector< std::size_t >& inpoel = *m_inpoel;
-  tk::Fields& u = *m_u;
+  Assert( m_inpoel && m_coord && m_usrc, "Source mesh data not set on worker" );
+  ErrChk( !weights || m_field != SourceField::CELL_LINEAR,
+          "Interpolation weights not available for linear cell fields" );
+  auto t0 = CkWallTimer();
+  const std::vector< tk::lindex >& inpoel = *m_inpoel;
+  const tk::Fields& u = *m_usrc;
   //CkPrintf("Source chare %i received data for %i potential collisions\n",
   //    thisIndex, nColls);
 
-  std::array< real, 4 > N;
-  int numInTet = 0;
-  std::vector<SolutionData> return_data;
+  const auto n = static_cast< std::size_t >( nColls );
+
+  // Convert box numbers to element ids if only a subset was registered
+  if (m_elems)
+    for (std::size_t i=0; i<n; ++i)
+      colls[i].source_index = (*m_elems)[ colls[i].source_index ];
+  std::vector< char > hit( n );
+  std::vector< tk::real > value( n );
+  std::vector< tk::real > dist( m_surface ? n : 0 );
+  std::vector< std::array< tk::real, MAX_NNPE > > shape( weights ? n : 0 );
+
+  // Value of the cell field in source cell e at a point
+  auto cellValue = [&]( std::size_t e, const DetailedCollision& coll ) {
+    auto v = u(e,0,0);
+    if (m_field == SourceField::CELL_LINEAR) {
+      const auto c = m_cellptr ? (*m_cellptr)[e] : e*4;
+      const auto nc = m_cellptr ? (*m_cellptr)[e+1] - c : 4;
+      std::array< real, 3 > x{{ 0.0, 0.0, 0.0 }};
+      for (std::size_t j=0; j<nc; ++j)
+        for (std::size_t d=0; d<3; ++d) x[d] += (*m_coord)[d][ inpoel[c+j] ];
+      for (auto& d : x) d /= static_cast< real >( nc );
+      v += u(e,1,0) * (coll.point.x - x[0]) +
+           u(e,2,0) * (coll.point.y - x[1]) +
+           u(e,3,0) * (coll.point.z - x[2]);
+    }
+    return v;
+  };
+
+  // Iterate over my potential collisions and determine call intet (or incell
+  // if the cells are of mixed type) to determine if an actual collision
+  // occurred, and if so what is the shape function
+  tk::parallelFor( n, [&]( std::size_t first, std::size_t last ){
+    std::array< real, 4 > N;
+    std::array< real, 3 > T;
+    std::array< real, MAX_NNPE > M;
+    for (auto i=first; i<last; ++i) {
+      const DetailedCollision& coll = colls[i];
+      if (m_surface) {
+        hit[i] = ontri(inpoel, *m_coord,
+                       {{ coll.point.x, coll.point.y, coll.point.z }},
+                       coll.source_index, m_tol, T, dist[i]);
+        if (hit[i]) {
+          std::size_t e = coll.source_index;
+          value[i] = T[0]*u(inpoel[e*3+0],0,0) + T[1]*u(inpoel[e*3+1],0,0) +
+                     T[2]*u(inpoel[e*3+2],0,0);
+          if (weights) std::copy( begin(T), end(T), begin(shape[i]) );
+        }
+        continue;
+      }
+      if (m_cellptr) {
+        std::size_t e = coll.source_index;
+        const auto c = (*m_cellptr)[e];
+        const auto nnpe = (*m_cellptr)[e+1] - c;
+        hit[i] = incell(inpoel, c, nnpe, *m_coord,
+                        {{ coll.point.x, coll.point.y, coll.point.z }}, M);
+        if (hit[i] && m_field != SourceField::NODE) {
+          value[i] = cellValue( e, coll );
+        } else if (hit[i]) {
+          value[i] = 0.0;
+          for (std::size_t j=0; j<nnpe; ++j)
+            value[i] += M[j] * u(inpoel[c+j],0,0);
+          if (weights) shape[i] = M;
+        }
+        continue;
+      }
+      hit[i] = intet(inpoel, *m_coord,
+                     {{ coll.point.x, coll.point.y, coll.point.z }},
+                     coll.source_index, N);
+      if (hit[i] && m_field != SourceField::NODE) {
+        value[i] = cellValue( coll.source_index, coll );
+      } else if (hit[i]) {
+        std::size_t e = coll.source_index;
+        const auto A = inpoel[e*4+0];
+        const auto B = inpoel[e*4+1];
+        const auto C = inpoel[e*4+2];
+        const auto D = inpoel[e*4+3];
+        value[i] =
+          N[0]*u(A,0,0) + N[1]*u(B,0,0) + N[2]*u(C,0,0) + N[3]*u(D,0,0);
+        if (weights) std::copy( begin(N), end(N), begin(shape[i]) );
+      }
+    }
+  }, static_cast< std::size_t >( g_parallelGrain ) );
+
+  // Keep only the closest of the surface triangles a dest point hit
+  if (m_surface) {
+    std::unordered_map< tk::lindex, std::size_t > closest;
+    for (std::size_t i=0; i<n; ++i) {
+      if (!hit[i]) continue;
+      auto c = closest.emplace( colls[i].dest_index, i );
+      if (c.second) continue;
+      if (dist[i] < dist[ c.first->second ]) {
+        hit[ c.first->second ] = 0;
+        c.first->second = i;
+      } else {
+        hit[i] = 0;
+      }
+    }
+  }
 
-  // Iterate over my potential collisions and determine call intet to determine
-  // if an actual collision occurred, and if so what is the shape function
-  for (int i = 0; i < nColls; i++) {
-    const DetailedCollision& coll = colls[i];
-    if (intet(coll.point, coll.source_index, N)) {
+  // Collect the solution data, and weights if requested, for the actual
+  // collisions, numbering the source nodes the dest chare needs. All points
+  // get m_nw weights, cells with fewer nodes pad theirs with zero weights of
+  // their last node. Cell fields send the cell as their single source node.
+  int numInTet = 0;
+  const std::size_t nnpe = m_surface ? 3 : 4;
+  SolutionBatch b{ proxy, index, m_firstchunk + thisIndex, thisIndex,
+                   {}, {}, {}, {}, {}, {} };
+  for (std::size_t i=0; i<n; ++i) {
+    if (hit[i]) {
       numInTet++;
-      SolutionData data;
-      data.dest_index = coll.dest_index;
-      auto e = coll.source_index;
-      const auto A = inpoel[e*4+0];
-      const auto B = inpoel[e*4+1];
-      const auto C = inpoel[e*4+2];
-      const auto D = inpoel[e*4+3];
-      data.solution = N[0]*u(A,0,0) + N[1]*u(B,0,0) + N[2]*u(C,0,0) + N[3]*u(D,0,0);
-      return_data.push_back(data);
+      b.m_index.push_back(colls[i].dest_index);
+      b.m_soln.push_back(value[i]);
+      if (m_surface) b.m_dist.push_back(dist[i]);
+      if (weights) {
+        auto& t = m_targets[ colls[i].dest_chunk ];
+        t.m_proxy = proxy;
+        t.m_index = index;
+        std::size_t e = colls[i].source_index;
+        if (m_field != SourceField::NODE) {
+          auto pos = t.m_pos.emplace( static_cast< tk::lindex >( e ),
+            static_cast< tk::lindex >( t.m_nodes.size() ) );
+          if (pos.second) t.m_nodes.push_back( pos.first->first );
+          b.m_node.push_back( pos.first->first );
+          b.m_pos.push_back( pos.first->second );
+          b.m_weight.push_back( 1.0 );
+          continue;
+        }
+        auto c = m_cellptr ? (*m_cellptr)[e] : e*nnpe;
+        auto nc = m_cellptr ? (*m_cellptr)[e+1] - c : nnpe;
+        for (std::size_t j=0; j<m_nw; ++j) {
+          auto p = inpoel[ c + std::min(j,nc-1) ];
+          auto pos = t.m_pos.emplace( p,
+            static_cast< tk::lindex >( t.m_nodes.size() ) );
+          if (pos.second) t.m_nodes.push_back( p );
+          b.m_node.push_back( p );
+          b.m_pos.push_back( pos.first->second );
+          b.m_weight.push_back( j < nc ? shape[i][j] : 0.0 );
+        }
+      }
     }
   }
+  auto ctrl = controllerProxy.ckLocalBranch();
+  auto dt = CkWallTimer() - t0;
+  m_load += dt;
+  ctrl->addTime( Phase::NARROW, dt );
+  ctrl->sourceCounts( m_firstchunk + thisIndex,
+                      static_cast< std::size_t >( nColls ),
+                      static_cast< std::size_t >( numInTet ) );
+
   // Send the solution data for the actual collisions back to the dest mesh
-  proxy[index].transferSolution(return_data.size(), return_data.data());
+  ctrl->sendSolution( std::move( b ) );
 }
 
 void
 Worker::transferSolution(
+    int sourceChunk,
+    int sourceIndex,
     std::size_t nPoints,
-    SolutionData* soln )
+    tk::lindex* dest_index,
+    tk::real* soln,
+    std::size_t nDist,
+    tk::real* dist,
+    std::size_t nWeights,
+    tk::lindex* nodes,
+    tk::lindex* pos,
+    tk::real* weights )
 // *****************************************************************************
 //  Receive the solution data for destination mesh points that collided with the
 //  source mesh tetrahedrons
+//! \param[in] sourceChunk Chunk id of the source mesh chare sending the data
+//! \param[in] sourceIndex Index of the source mesh chare sending the data
 //! \param[in] nPoints Number of solutions found
-//! \param[in] colls List of solutions
+//! \param[in] dest_index Destination mesh point indices of solutions
+//! \param[in] soln List of solutions
+//! \param[in] nDist Number of distances from the source surface, one per
+//!   solution if the source is a surface, zero otherwise
+//! \param[in] dist Distances of the dest points from the source surface
+//! \param[in] nWeights Number of interpolation weights, the same number per
+//!   solution, that of the largest source cell, if requested, zero otherwise
+//! \param[in] nodes Source mesh nodes of the interpolation weights
+//! \param[in] pos Position of the source node values sent when applying weights
+//! \param[in] weights Interpolation weights
 // *****************************************************************************
 {
-  tk::Fields& u = *m_u;
   //CkPrintf("Dest worker %i received %lu solution points\n", thisIndex, nPoints);
+  auto t0 = CkWallTimer();
+  Assert( nWeights == 0 ||
+          (m_weights && nPoints > 0 && nWeights % nPoints == 0),
+          "Number of interpolation weights inconsistent with solutions" );
+  Assert( nDist == 0 || nDist == nPoints,
+          "Number of distances inconsistent with solutions" );
 
-  for (int i = 0; i < static_cast<int>(nPoints); i++) {
-    u(soln[i].dest_index,0,0) = soln[i].solution;
+  // Store the solution, and the interpolation weights if requested. The
+  // closest source surface wins, otherwise the last source chare to send a
+  // value for a point.
+  const auto nw = nWeights > 0 ? nWeights / nPoints : 0;
+  if (nWeights > 0) m_wsources.insert( sourceChunk );
+  if (nw > m_wstride) growWeights( nw );
+  for (std::size_t i = 0; i < nPoints; i++) {
+    auto p = dest_index[i];
+    if (nDist > 0) {
+      if (m_found[p] && dist[i] >= m_dist[p]) continue;
+      m_dist[p] = dist[i];
+    }
+    m_staged[p] = soln[i];
+    m_found[p] = 1;
+    if (nWeights > 0) {
+      m_wchunk[p] = sourceChunk;
+      m_wchare[p] = sourceIndex;
+      for (std::size_t j=0; j<m_wstride; ++j) {
+        auto k = i*nw + std::min( j, nw-1 );
+        m_wnode[p*m_wstride+j] = nodes[k];
+        m_wpos[p*m_wstride+j] = pos[k];
+        m_wweight[p*m_wstride+j] = j < nw ? weights[k] : 0.0;
+      }
+    }
   }
+  m_load += CkWallTimer() - t0;
+
+  receivedMsg();
+}
+
+void
+Worker::done() {
+  receivedMsg();
+}
+
+void
+Worker::receivedMsg()
+// *****************************************************************************
+//  Count a message received by the destination mesh and, if all expected
+//  messages arrived, account for diagnostics and inform the caller
+// *****************************************************************************
+{
+  auto ctrl = controllerProxy.ckLocalBranch();
+  ctrl->received();
 
   // Inform the caller if we've received all solution data
   m_numreceived++;
   if (m_numreceived == m_numsent) {
-    m_donecb.send();
+    if (m_points) {
+      // Only count the points transferred into
+      std::vector< uint32_t > candidates;
+      std::vector< char > found;
+      for (auto p : *m_points) {
+        candidates.push_back( m_candidates[p] );
+        found.push_back( m_found[p] );
+      }
+      ctrl->destCounts( m_firstchunk + thisIndex, candidates, found );
+    } else {
+      ctrl->destCounts( m_firstchunk + thisIndex, m_candidates, m_found );
+    }
+    if (m_weights) buildWeights();
+    m_ready = true;
+    m_readycb.send();
+    if (m_waiting) applyTransfer();
   }
 }
 
 void
-Worker::done() {
-  m_numreceived++;
-  if (m_numreceived == m_numsent) {
-    m_donecb.send();
+Worker::applyTransfer()
+// *****************************************************************************
+//  Apply the solution received to the destination mesh and inform the caller
+//! \details Only points that received a value are overwritten.
+// *****************************************************************************
+{
+  auto t0 = CkWallTimer();
+  tk::Fields& u = *m_u;
+  for (std::size_t p=0; p<m_staged.size(); ++p)
+    if (m_found[p]) u(p,0,0) = m_staged[p];
+  m_load += CkWallTimer() - t0;
+
+  m_waiting = false;
+  m_donecb.send();
+}
+
+void
+Worker::growWeights( std::size_t nw )
+// *****************************************************************************
+//  Increase the number of source nodes and weights stored per dest point
+//! \param[in] nw New number of source nodes and weights per dest point
+//! \details Weights already stored are padded with zero weights of their last
+//!   node, so all points of the chare keep the same number of weights, that
+//!   of the largest source cell a point of the chare was found in.
+// *****************************************************************************
+{
+  Assert( nw > m_wstride, "Number of weights per point must grow" );
+
+  const auto npoin = m_wchunk.size();
+  std::vector< tk::lindex > node( npoin*nw ), pos( npoin*nw );
+  std::vector< tk::real > weight( npoin*nw, 0.0 );
+  for (std::size_t p=0; p<npoin; ++p)
+    for (std::size_t j=0; j<nw; ++j) {
+      auto k = p*m_wstride + std::min( j, m_wstride-1 );
+      node[p*nw+j] = m_wnode[k];
+      pos[p*nw+j] = m_wpos[k];
+      if (j < m_wstride) weight[p*nw+j] = m_wweight[k];
+    }
+
+  m_wnode = std::move( node );
+  m_wpos = std::move( pos );
+  m_wweight = std::move( weight );
+  m_wstride = nw;
+}
+
+void
+Worker::buildWeights()
+// *****************************************************************************
+//  Build the CSR interpolation weights once the transfer is complete
+// *****************************************************************************
+{
+  const auto npoin = m_wchunk.size();
+  m_csr = TransferWeights();
+  m_csr.m_rowptr.assign( npoin+1, 0 );
+  for (std::size_t p=0; p<npoin; ++p) {
+    if (m_wchunk[p] >= 0) {
+      for (std::size_t j=0; j<m_wstride; ++j) {
+        m_csr.m_chare.push_back( m_wchare[p] );
+        m_csr.m_node.push_back( m_wnode[p*m_wstride+j] );
+        m_csr.m_weight.push_back( m_wweight[p*m_wstride+j] );
+      }
+    }
+    m_csr.m_rowptr[p+1] = m_csr.m_node.size();
   }
 }
 
-bool
-Worker::intet(const CkVector3d &point,
-      std::size_t e,
-      std::array< real, 4 >& N) const
-  // *****************************************************************************
-  //  Determine if a point is in a tetrahedron and evaluate the shapefunction
-  //! \param[in] point Point coordinates
-  //! \param[in] e Mesh cell index
-  //! \param[in,out] N Shapefunctions evaluated at the point
-  //! \return True if ppoint is in mesh cell
-  //! \see Lohner, An Introduction to Applied CFD Techniques, Wiley, 2008
-  // *****************************************************************************
+void
+Worker::applyWeights()
+// *****************************************************************************
+//  Apply the interpolation weights to the destination mesh if the application
+//  waits for it and the values of all source chares have arrived
+// *****************************************************************************
 {
-  const std::vector< std::size_t >& inpoel = *m_inpoel;
-  const tk::UnsMesh::Coords& coord = *m_coord;
+  if (!m_applying || m_applied.size() < m_wsources.size()) return;
 
-  // Tetrahedron node indices
-  const auto A = inpoel[e*4+0];
-  const auto B = inpoel[e*4+1];
-  const auto C = inpoel[e*4+2];
-  const auto D = inpoel[e*4+3];
-
-  // Tetrahedron node coordinates
-  const auto& x = coord[0];
-  const auto& y = coord[1];
-  const auto& z = coord[2];
-
-  // Point coordinates
-  const auto& xp = point.x;
-  const auto& yp = point.y;
-  const auto& zp = point.z;
-
-  // Evaluate linear shapefunctions at point locations using Cramer's Rule
-  //    | xp |   | x1 x2 x3 x4 |   | N1 |
-  //    | yp | = | y1 y2 y3 y4 | • | N2 |
-  //    | zp |   | z1 z2 z3 z4 |   | N3 |
-  //    | 1  |   | 1  1  1  1  |   | N4 |
-
-  real DetX = (y[B]*z[C] - y[C]*z[B] - y[B]*z[D] + y[D]*z[B] +
-      y[C]*z[D] - y[D]*z[C])*x[A] + x[B]*y[C]*z[A] - x[B]*y[A]*z[C] +
-    x[C]*y[A]*z[B] - x[C]*y[B]*z[A] + x[B]*y[A]*z[D] - x[B]*y[D]*z[A] -
-    x[D]*y[A]*z[B] + x[D]*y[B]*z[A] - x[C]*y[A]*z[D] + x[C]*y[D]*z[A] +
-    x[D]*y[A]*z[C] - x[D]*y[C]*z[A] - x[B]*y[C]*z[D] + x[B]*y[D]*z[C] +
-    x[C]*y[B]*z[D] - x[C]*y[D]*z[B] - x[D]*y[B]*z[C] + x[D]*y[C]*z[B];
-
-  real DetX1 = (y[D]*z[C] - y[C]*z[D] + y[C]*zp - yp*z[C] -
-      y[D]*zp + yp*z[D])*x[B] + x[C]*y[B]*z[D] - x[C]*y[D]*z[B] -
-    x[D]*y[B]*z[C] + x[D]*y[C]*z[B] - x[C]*y[B]*zp + x[C]*yp*z[B] +
-    xp*y[B]*z[C] - xp*y[C]*z[B] + x[D]*y[B]*zp - x[D]*yp*z[B] -
-    xp*y[B]*z[D] + xp*y[D]*z[B] + x[C]*y[D]*zp - x[C]*yp*z[D] -
-    x[D]*y[C]*zp + x[D]*yp*z[C] + xp*y[C]*z[D] - xp*y[D]*z[C];
-
-  real DetX2 = (y[C]*z[D] - y[D]*z[C] - y[C]*zp + yp*z[C] +
-      y[D]*zp - yp*z[D])*x[A] + x[C]*y[D]*z[A] - x[C]*y[A]*z[D] +
-    x[D]*y[A]*z[C] - x[D]*y[C]*z[A] + x[C]*y[A]*zp - x[C]*yp*z[A] -
-    xp*y[A]*z[C] + xp*y[C]*z[A] - x[D]*y[A]*zp + x[D]*yp*z[A] +
-    xp*y[A]*z[D] - xp*y[D]*z[A] - x[C]*y[D]*zp + x[C]*yp*z[D] +
-    x[D]*y[C]*zp - x[D]*yp*z[C] - xp*y[C]*z[D] + xp*y[D]*z[C];
-
-  real DetX3 = (y[D]*z[B] - y[B]*z[D] + y[B]*zp - yp*z[B] -
-      y[D]*zp + yp*z[D])*x[A] + x[B]*y[A]*z[D] - x[B]*y[D]*z[A] -
-    x[D]*y[A]*z[B] + x[D]*y[B]*z[A] - x[B]*y[A]*zp + x[B]*yp*z[A] +
-    xp*y[A]*z[B] - xp*y[B]*z[A] + x[D]*y[A]*zp - x[D]*yp*z[A] -
-    xp*y[A]*z[D] + xp*y[D]*z[A] + x[B]*y[D]*zp - x[B]*yp*z[D] -
-    x[D]*y[B]*zp + x[D]*yp*z[B] + xp*y[B]*z[D] - xp*y[D]*z[B];
-
-  real DetX4 = (y[B]*z[C] - y[C]*z[B] - y[B]*zp + yp*z[B] +
-      y[C]*zp - yp*z[C])*x[A] + x[B]*y[C]*z[A] - x[B]*y[A]*z[C] +
-    x[C]*y[A]*z[B] - x[C]*y[B]*z[A] + x[B]*y[A]*zp - x[B]*yp*z[A] -
-    xp*y[A]*z[B] + xp*y[B]*z[A] - x[C]*y[A]*zp + x[C]*yp*z[A] +
-    xp*y[A]*z[C] - xp*y[C]*z[A] - x[B]*y[C]*zp + x[B]*yp*z[C] +
-    x[C]*y[B]*zp - x[C]*yp*z[B] - xp*y[B]*z[C] + xp*y[C]*z[B];
-
-  // Shape functions evaluated at point
-  N[0] = DetX1/DetX;
-  N[1] = DetX2/DetX;
-  N[2] = DetX3/DetX;
-  N[3] = DetX4/DetX;
-
-  // if min( N^i, 1-N^i ) > 0 for all i, point is in cell
-  if ( std::min(N[0],1.0-N[0]) > 0 && std::min(N[1],1.0-N[1]) > 0 &&
-      std::min(N[2],1.0-N[2]) > 0 && std::min(N[3],1.0-N[3]) > 0 )
-  {
-    return true;
-  } else {
-    return false;
+  auto t0 = CkWallTimer();
+  tk::Fields& u = *m_u;
+  for (std::size_t p=0; p<m_wchunk.size(); ++p) {
+    if (m_wchunk[p] < 0) continue;
+    const auto& vals = m_applied.at( m_wchunk[p] );
+    tk::real v = 0.0;
+    for (std::size_t j=0; j<m_wstride; ++j)
+      v += m_wweight[p*m_wstride+j] * vals[ m_wpos[p*m_wstride+j] ];
+    u(p,0,0) = v;
   }
+  m_load += CkWallTimer() - t0;
+
+  m_applied.clear();
+  m_applying = false;
+  m_applycb.send();
 }
 
 #include "NoWarning/worker.def.h"
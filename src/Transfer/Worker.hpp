@@ -10,21 +10,37 @@
 #ifndef Worker_h
 #define Worker_h
 
+#include <map>
+#include <set>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
 #include "Types.hpp"
 #include "PUPUtil.hpp"
 #include "UnsMesh.hpp"
 #include "CommMap.hpp"
 #include "Fields.hpp"
+#include "Controller.hpp"
 
 #include "NoWarning/worker.decl.h"
 
 namespace exam2m {
 
-class SolutionData {
-  public:
-    std::size_t dest_index;
-    tk::real solution;
-    void pup(PUP::er& p) { p | dest_index; p | solution; }
+//! Source mesh nodes a dest mesh chare needs to apply interpolation weights
+struct ApplyTarget {
+  CProxy_Worker m_proxy;        //!< Dest mesh chare array
+  int m_index;                  //!< Dest mesh chare index
+  //! Source nodes whose values are sent, in the order sent
+  std::vector< tk::lindex > m_nodes;
+  //! Position of source nodes in m_nodes
+  std::unordered_map< tk::lindex, tk::lindex > m_pos;
+  void pup(PUP::er& p) {
+    p | m_proxy;
+    p | m_index;
+    p | m_nodes;
+    p | m_pos;
+  }
 };
 
 //! Worker chare array holding part of a mesh
@@ -39,21 +55,81 @@ class Worker : public CBase_Worker {
       #pragma clang diagnostic ignored "-Wundefined-func-template"
     #endif
     //! Migrate constructor
+    //! \details Pointers to mesh data are rebound by the application passing
+    //!   them to the library at the start of the next transfer.
     // cppcheck-suppress uninitMemberVar
-    explicit Worker( CkMigrateMessage* ) {}
+    explicit Worker( CkMigrateMessage* ) :
+      m_inpoel( nullptr ), m_cellptr( nullptr ), m_elems( nullptr ),
+      m_coord( nullptr ), m_u( nullptr ), m_usrc( nullptr ),
+      m_points( nullptr ) {}
     #if defined(__clang__)
       #pragma clang diagnostic pop
     #endif
 
     //! Set the source mesh data
-    void setSourceTets( std::vector< std::size_t>* inpoel,
+    void setSourceTets( std::vector< tk::lindex >* inpoel,
+                        tk::UnsMesh::Coords* coords,
+                        const tk::Fields& u,
+                        const std::vector< tk::lindex >* elems,
+                        SourceField field );
+
+    //! Set the source mesh data of a mesh of mixed cell types
+    void setSourceCells( std::vector< tk::lindex >* inpoel,
+                         const std::vector< std::size_t >* cellptr,
+                         tk::UnsMesh::Coords* coords,
+                         const tk::Fields& u,
+                         const std::vector< tk::lindex >* elems,
+                         SourceField field );
+
+    //! Set the source surface data of a surface transfer
+    void setSourceTris( std::vector< tk::lindex >* triinpoel,
                         tk::UnsMesh::Coords* coords,
-                        const tk::Fields& u );
+                        const tk::Fields& u,
+                        tk::real tol,
+                        const std::vector< tk::lindex >* elems );
 
     //! Set the destination mesh data
     void setDestPoints( tk::UnsMesh::Coords* coords,
                         const tk::Fields& u,
-                        CkCallback cb );
+                        CkCallback cb,
+                        const std::vector< tk::lindex >* points );
+
+    //! Start a split-phase transfer into the destination mesh
+    int startTransfer( tk::UnsMesh::Coords* coords,
+                       tk::Fields& u,
+                       CkCallback cb,
+                       bool weights,
+                       const std::vector< tk::lindex >* points );
+
+    //! Query if all data of a split-phase transfer has arrived
+    bool transferReady( int id ) const;
+
+    //! Complete a split-phase transfer by applying the data received
+    void waitTransfer( int id, CkCallback cb );
+
+    //! Return the interpolation weights of the last transfer into the dest mesh
+    const TransferWeights& weights() const;
+
+    //! Send the source values needed to apply the interpolation weights
+    void applySource( const tk::Fields& u );
+
+    //! Apply the interpolation weights to the source values received
+    void applyDest( tk::Fields& u, CkCallback cb );
+
+    //! Receive the source values needed to apply the interpolation weights
+    void applyValues( int chunk, std::size_t n, tk::real* vals );
+
+    //! Contribute the content hash of the mesh chunk to a reduction
+    void hashMesh( const std::vector< tk::lindex >& inpoel,
+                   const tk::UnsMesh::Coords& coords,
+                   CkCallback cb );
+
+    //! Save the transfer plan of the last transfer to file
+    void savePlan( const std::string& prefix, std::uint64_t key );
+
+    //! Load a transfer plan from file
+    bool loadPlan( const std::string& prefix, std::uint64_t key,
+                   std::size_t npoin );
 
     //! Process potential collisions in the destination mesh
     void processCollisions( int nColls,
@@ -62,20 +138,76 @@ class Worker : public CBase_Worker {
     //! Identify actual collisions in the source mesh
     void determineActualCollisions( CProxy_Worker proxy,
                                     int index,
+                                    bool weights,
                                     int nColls,
-                                    DetailedCollision* colls ) const;
+                                    DetailedCollision* colls );
 
     //! Transfer the interpolated solution data back to destination mesh
-    void transferSolution( std::size_t nPoints, SolutionData* soln );
+    void transferSolution( int sourceChunk,
+                           int sourceIndex,
+                           std::size_t nPoints,
+                           tk::lindex* dest_index,
+                           tk::real* soln,
+                           std::size_t nDist,
+                           tk::real* dist,
+                           std::size_t nWeights,
+                           tk::lindex* nodes,
+                           tk::lindex* pos,
+                           tk::real* weights );
 
     void done();
 
+    //! Return and reset the transfer time spent since the last call
+    double load();
+
+    //! Unregister from the collision detection library before migration
+    void ckAboutToMigrate() override;
+
+    //! Register with the collision detection library and controller after
+    //! migration
+    void ckJustMigrated() override;
+
     /** @name Charm++ pack/unpack serializer member functions */
     ///@{
     //! \brief Pack/Unpack serialize member function
     //! \param[in,out] p Charm++'s PUP::er serializer object reference
+    //! \details Pointers to the mesh data are not migrated, as they point
+    //!   into the bound application array element and are only used during a
+    //!   transfer, so the worker must not migrate while a transfer is in
+    //!   progress.
     void pup( PUP::er &p ) override {
       p | m_firstchunk;
+      p | m_array;
+      p | m_mesh;
+      p | m_surface;
+      p | m_tol;
+      p | m_nw;
+      PUP::pup( p, m_field );
+      p | m_staged;
+      p | m_dist;
+      p | m_numsent;
+      p | m_numreceived;
+      p | m_readycb;
+      p | m_donecb;
+      p | m_transfer;
+      p | m_ready;
+      p | m_waiting;
+      p | m_candidates;
+      p | m_found;
+      p | m_load;
+      p | m_targets;
+      p | m_weights;
+      p | m_wchunk;
+      p | m_wchare;
+      p | m_wstride;
+      p | m_wnode;
+      p | m_wpos;
+      p | m_wweight;
+      p | m_wsources;
+      p | m_csr;
+      p | m_applied;
+      p | m_applycb;
+      p | m_applying;
     }
     //! \brief Pack/Unpack serialize operator|
     //! \param[in,out] p Charm++'s PUP::er serializer object reference
@@ -86,30 +218,122 @@ class Worker : public CBase_Worker {
   private:
     //! The ID of my first chunk (used for collision detection library)
     int m_firstchunk;
-    //! Pointer to element connectivity
-    std::vector< std::size_t >* m_inpoel;
+    //! Application array this worker is bound to
+    CkArrayID m_array;
+    //! Mesh data registered with the controller
+    MeshData m_mesh;
+    //! Pointer to element connectivity, surface triangles if m_surface
+    std::vector< tk::lindex >* m_inpoel;
+    //! Pointer to the offsets of the source cells in m_inpoel, one more than
+    //! cells, if the source cells are of mixed type, nullptr for tets
+    const std::vector< std::size_t >* m_cellptr;
+    //! True if the source is a surface, given by triangles
+    bool m_surface;
+    //! Largest distance of dest points from the source surface accepted
+    tk::real m_tol;
+    //! Largest number of nodes of the source cells, i.e., of the interpolation
+    //! weights sent per dest point
+    std::size_t m_nw;
+    //! Location of the source solution values, in nodes or cells
+    SourceField m_field;
+    //! Source elements to transfer from, all elements if nullptr
+    const std::vector< tk::lindex >* m_elems;
     //! Pointer to point coordinates
     tk::UnsMesh::Coords* m_coord;
     //! Pointer to solution in mesh nodes
     tk::Fields* m_u;
+    //! Pointer to solution of the source mesh, transferred from
+    const tk::Fields* m_usrc;
+    //! Dest mesh nodes to transfer into, all nodes if nullptr
+    const std::vector< tk::lindex >* m_points;
+    //! Solution received in dest mesh nodes, applied to m_u when waited on
+    std::vector< tk::real > m_staged;
+    //! Distance of dest mesh nodes from the source surface they received a
+    //! value from, if the source is a surface
+    std::vector< tk::real > m_dist;
 
     //! The number of messages sent by the dest mesh
     int m_numsent;
     //! The number of messages received by the dest mesh
     int m_numreceived;
     //! Called once the transfer is complete (m_numsent == m_numreceived)
+    CkCallback m_readycb;
+    //! Called once the data received has been applied to m_u
     CkCallback m_donecb;
+    //! Sequence number of the last transfer started into the dest mesh
+    int m_transfer;
+    //! True if all data of the last transfer into the dest mesh has arrived
+    bool m_ready;
+    //! True if the application waits for the last transfer to be applied
+    bool m_waiting;
+    //! Number of broad-phase candidates of each dest point (diagnostics)
+    std::vector< uint32_t > m_candidates;
+    //! Nonzero for each dest point that received a value (diagnostics)
+    std::vector< char > m_found;
+    //! Transfer time spent as source and dest since the last load query
+    double m_load;
+
+    //! Source nodes each dest mesh chare needs to apply interpolation
+    //! weights, keyed by the chunk id of the dest chare
+    std::map< int, ApplyTarget > m_targets;
+    //! True if interpolation weights were requested for the last transfer
+    //! into the dest mesh
+    bool m_weights;
+    //! Source chunk id of each dest point that received a value, -1 if none
+    std::vector< int > m_wchunk;
+    //! Source mesh chare index of each dest point that received a value
+    std::vector< int > m_wchare;
+    //! Number of source nodes and interpolation weights stored per dest point
+    std::size_t m_wstride;
+    //! Source nodes of each dest point, m_wstride per point
+    std::vector< tk::lindex > m_wnode;
+    //! Position of the source node values received when applying weights
+    std::vector< tk::lindex > m_wpos;
+    //! Interpolation weights of each dest point, m_wstride per point
+    std::vector< tk::real > m_wweight;
+    //! Chunk ids of source chares that sent interpolation weights
+    std::set< int > m_wsources;
+    //! Interpolation weights in CSR form, built once the transfer is complete
+    TransferWeights m_csr;
+    //! Source values received for applying weights, keyed by source chunk id
+    std::map< int, std::vector< tk::real > > m_applied;
+    //! Called once the interpolation weights have been applied to m_u
+    CkCallback m_applycb;
+    //! True if the application waits for weights to be applied
+    bool m_applying;
+
+    //! Count a message received by the dest mesh and finish if all arrived
+    void receivedMsg();
+
+    //! Apply the solution received to the dest mesh and inform the caller
+    void applyTransfer();
+
+    //! Set the location of the source solution values after checking them
+    void setField( SourceField field,
+                   const tk::Fields& u,
+                   std::size_t ncells );
+
+    //! Increase the number of source nodes and weights stored per dest point
+    void growWeights( std::size_t nw );
+
+    //! Build the CSR interpolation weights once the transfer is complete
+    void buildWeights();
+
+    //! Apply the weights to the dest mesh if all source values have arrived
+    void applyWeights();
+
+    //! Return the name of the file storing the transfer plan of this chare
+    std::string planFile( const std::string& prefix, std::uint64_t key ) const;
+
+    //! Pack/Unpack the transfer plan to/from file
+    void pupPlan( PUP::er& p );
 
     //! Contribute vertex information to the collsion detection library
     void collideVertices();
 
-    //! Contribute tet information to the collision detection library
+    //! Contribute cell (or surface triangle) information to the collision
+    //! detection library
     void collideTets() const;
-
-    //! Determine if a point is in a tet
-    bool intet(const CkVector3d &point,
-               std::size_t e,
-               std::array< tk::real, 4 >& N) const;
 };
 
 } // exam2m::